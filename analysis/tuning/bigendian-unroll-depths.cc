@@ -0,0 +1,74 @@
+// This program runs the timed BigEndianUnrollSelector of each unrolled
+// family of bigendianuniversal.h many times and prints tuples of
+//
+// 1. The family
+// 2. The range of lengths, 0 to 4 (below 8, 32, 128, 512 words and the rest)
+// 3. A depth of that family
+// 4. How many of the runs picked that depth for that range
+//
+// followed, for each family, by the depth picked most often in each
+// range. A single timed pick is noisy; the most frequent picks are what
+// the default depth tables of bigendianuniversal.h are taken from.
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#include "bigendianuniversal.h"
+extern "C" {
+#include "pcg.h"
+}
+
+// How many times each family is timed
+const size_t RUNS = 1001;
+
+struct Family {
+  const UnrollCandidate *candidates;
+  size_t count;
+  const char *name;
+};
+
+int main() {
+  const Family families[] = {
+      {unrolledHornerCandidates,
+       sizeof(unrolledHornerCandidates) / sizeof(unrolledHornerCandidates[0]),
+       "unrolledHorner"},
+      {iterateCLCandidates,
+       sizeof(iterateCLCandidates) / sizeof(iterateCLCandidates[0]),
+       "iterateCL"},
+      {treeCLCandidates,
+       sizeof(treeCLCandidates) / sizeof(treeCLCandidates[0]), "treeCL"},
+  };
+  uint64_t keys[150];
+  for (size_t i = 0; i < 150; ++i) keys[i] = pcg64_random();
+  cout << "# family range depth wins-out-of-" << RUNS << endl;
+  for (const Family &family : families) {
+    vector<vector<size_t> > wins(BigEndianUnrollSelector::RANGES,
+                                 vector<size_t>(family.count, 0));
+    for (size_t run = 0; run < RUNS; ++run) {
+      const BigEndianUnrollSelector selector(family.candidates, family.count,
+                                             keys);
+      for (size_t r = 0; r < BigEndianUnrollSelector::RANGES; ++r) {
+        for (size_t c = 0; c < family.count; ++c) {
+          if (family.candidates[c].depth == selector.depth(r)) ++wins[r][c];
+        }
+      }
+    }
+    size_t most[BigEndianUnrollSelector::RANGES];
+    for (size_t r = 0; r < BigEndianUnrollSelector::RANGES; ++r) {
+      size_t best = 0;
+      for (size_t c = 0; c < family.count; ++c) {
+        cout << family.name << " " << r << " " << family.candidates[c].depth
+             << " " << wins[r][c] << endl;
+        if (wins[r][c] > wins[r][best]) best = c;
+      }
+      most[r] = family.candidates[best].depth;
+    }
+    cout << "# " << family.name << " most picked: {{";
+    for (size_t r = 0; r < BigEndianUnrollSelector::RANGES; ++r) {
+      cout << (r == 0 ? "" : ", ") << most[r];
+    }
+    cout << "}}" << endl << endl;
+  }
+}
@@ -87,13 +87,14 @@ extern "C" {
 #include "ghash.h"
 #include "clmulhierarchical64bits.h"
 }
+#include "bigendianuniversal.h"
 
 #include "treehash/binary-treehash.hh"
 #include "treehash/generic-treehash.hh"
 
 
-#define HowManyFunctions 13
-#define HowManyFunctions64 11
+#define HowManyFunctions 18
+#define HowManyFunctions64 20
 
 hashFunction64 funcArr64[HowManyFunctions64] = {&hashCity,
                                                 &hashVHASH64,
@@ -106,12 +107,22 @@ hashFunction64 funcArr64[HowManyFunctions64] = {&hashCity,
                                                 &generic_treehash<BoostedZeroCopyGenericBinaryTreehash, NHCL, 7>,
                                                 &generic_treehash<BoostedZeroCopyGenericBinaryTreehash, NH, 7>,
                                                 &hashPMP64,
+                                                &hashSipHash13,
+                                                &hashHalfSipHash64,
+                                                &GHASH64bit8way,
+                                                &POLYVAL64bit,
+                                                &CLMULPoly64x8,
+                                                &hornerHash,
+                                                &hornerHashLanes8,
+                                                &hashMultilinear64,
+                                                &hashMultilinear64avx,
                                                };
 
 hashFunction funcArr[HowManyFunctions] = {&hashGaloisFieldMultilinear,
     &hashGaloisFieldMultilinearHalfMultiplications, &hashMultilinear,
     &hashMultilinear2by2, &hashMultilinearhalf, &hashMultilineardouble, &hashNH,
-    &hashRabinKarp, &hashFNV1, &hashFNV1a, &hashSAX, &pyramidal_Multilinear, &pdp32avx};
+    &hashRabinKarp, &hashFNV1, &hashFNV1a, &hashSAX, &pyramidal_Multilinear, &pdp32avx,
+    &hashPMP32, &hashPMP64out32, &hashHalfSipHash, &hashMultilinearavx, &hashMultilinearhalfavx};
 
 const char* functionnames64[HowManyFunctions64] = {
     "Google's City                       ",
@@ -124,7 +135,16 @@ const char* functionnames64[HowManyFunctions64] = {
     "generic_tree<Boosted..., CLNH, 7>   ",
     "generic_tree<Boosted..., NHCL, 7>   ",
     "generic_tree<Boosted..., NH, 7>     ",
-    "PMP64                               "
+    "PMP64                               ",
+    "SipHash-1-3                         ",
+    "HalfSipHash (64-bit output)         ",
+    "GHASH (8-way aggregation)           ",
+    "POLYVAL (8-way aggregation)         ",
+    "CLMULPoly64 (8-way, prepared key)   ",
+    "Horner (big-endian universal)       ",
+    "Horner, 8 lanes (big-endian univ.)  ",
+    "Multilinear64 (strongly universal)  ",
+    "Multilinear64 AVX (strongly univ.)  "
 };
 
 const char* functionnames[HowManyFunctions] = {
@@ -141,16 +161,22 @@ const char* functionnames[HowManyFunctions] = {
     "SAX                                 ",
     "Pyramidal multilinear (a. univ.)    ",
     "pdp32avx                            ",
+    "PMP32                               ",
+    "PMP64 (32-bit output)               ",
+    "HalfSipHash                         ",
+    "Multilinear AVX (strongly universal)",
+    "Multilinearhalf AVX (s. universal)  ",
 };
 #else
 
-#define HowManyFunctions 10
+#define HowManyFunctions 13
 #define HowManyFunctions64 3
 
 hashFunction funcArr[HowManyFunctions] = { &hashMultilinear,
                                            &hashMultilinear2by2, &hashMultilinearhalf, &hashMultilineardouble,
                                            &hashNH, &hashRabinKarp, &hashFNV1, &hashFNV1a, &hashSAX,
-                                           &pyramidal_Multilinear
+                                           &pyramidal_Multilinear, &hashPMP32, &hashPMP64out32,
+                                           &hashHalfSipHash
                                          };
 hashFunction64 funcArr64[HowManyFunctions64] = { &hashCity,
                                                  &hashMMH_NonPyramidal, &hashNH64
@@ -166,7 +192,10 @@ const char* functionnames[HowManyFunctions] = {
     "FNV1                                ",
     "FNV1a                               ",
     "SAX                                 ",
-    "Pyramidal multilinear (a. univ.)    "
+    "Pyramidal multilinear (a. univ.)    ",
+    "PMP32                               ",
+    "PMP64 (32-bit output)               ",
+    "HalfSipHash                         "
 };
 const char* functionnames64[HowManyFunctions64] = {
     "Google's City                       ",
@@ -198,7 +227,8 @@ int main(int argc, char ** arg) {
     const char * functionname;
     ticks bef, aft;
     struct timeval start, finish;
-    uint64_t randbuffer[N + 3] __attribute__ ((aligned (32)));
+    // hashMultilinear64 reads 2 * (N / 2 + 2) random words
+    uint64_t randbuffer[N + 4] __attribute__ ((aligned (32)));
     uint32_t sumToFoolCompiler = 0;
     uint32_t intstring[N] __attribute__ ((aligned (32)));
     int c;
@@ -218,7 +248,7 @@ int main(int argc, char ** arg) {
             abort();
         }
 
-    for (i = 0; i < N + 3; ++i) {
+    for (i = 0; i < N + 4; ++i) {
         randbuffer[i] = rand() | ((uint64_t)(rand()) << 32);
     }
     for (i = 0; i < N; ++i) {
@@ -99,6 +99,21 @@ int equal(__m128i a, __m128i b) {
            && (_mm_extract_epi32(a,3) == _mm_extract_epi32(b,3));
 }
 
+// Cycles per 128x128-bit product of the clmul.h kernels: STEP makes PRODUCTS products and
+// feeds them into the next step, as in the tests above. The empty asm on RESULT keeps the
+// compiler from sinking the loop past the second timestamp.
+#define TIMEKERNEL(NAME, PRODUCTS, RESULT, STEP)                                           \
+    {                                                                                      \
+        bef = startRDTSC();                                                                \
+        for (j = 0; j < SHORTTRIALS; ++j) {                                                \
+            STEP;                                                                          \
+        }                                                                                  \
+        __asm__ volatile("" : "+x"(RESULT));                                               \
+        aft = stopRDTSCP();                                                                \
+        printf("[%-32s] CPU cycle/product = %f \n", NAME,                                  \
+               (aft - bef) * 1.0 / (PRODUCTS * 1.0 * SHORTTRIALS));                        \
+    }
+
 int main(int argc, char ** arg) {
     int SHORTTRIALS = 1000000;
     int HowManyRepeats = 5;
@@ -196,6 +211,44 @@ int main(int argc, char ** arg) {
         printf("\n");
     }
 
-    printf("\n");
+    printf("clmul.h kernels (CLMUL_KARATSUBA = %d, CLMUL_WIDE = %d)\n", CLMUL_KARATSUBA, CLMUL_WIDE);
+    {
+        __m128i X = A, Y = B;
+        __m128i P[8], Q[8];
+        for (k = 0; k < 8; ++k) {
+            P[k] = _mm_set1_epi32(~(3 * k));
+            Q[k] = _mm_set1_epi32(~(3 * k + 1));
+        }
+        TIMEKERNEL("schoolbook (4 CLMUL)", 1, X,
+                   mul128by128to256_schoolbook(X, Y, &X, &Y); X = _mm_xor_si128(X, A); Y = _mm_xor_si128(Y, B))
+        TIMEKERNEL("Karatsuba (3 CLMUL)", 1, X,
+                   mul128by128to256_karatsuba(X, Y, &X, &Y); X = _mm_xor_si128(X, A); Y = _mm_xor_si128(Y, B))
+        TIMEKERNEL("lazymod127 (with reduction)", 1, X,
+                   X = mul128by128to128_lazymod127(X, Y); X = _mm_xor_si128(X, A))
+        TIMEKERNEL("2by2, one combination", 2, X,
+                   mul128by128to256_2by2(X, Y, A, B, &X, &Y); X = _mm_xor_si128(X, A))
+        TIMEKERNEL("4by4, one combination", 4, X,
+                   mul128by128to256_4by4(X, Y, A, B, Y, X, B, A, &X, &Y); X = _mm_xor_si128(X, A))
+        TIMEKERNEL("lazymod127_4by4 (with reduction)", 4, Y,
+                   X = mul128by128to128_lazymod127_4by4(X, Y, A, B, Y, X, B, A); Y = _mm_xor_si128(Y, X))
+        TIMEKERNEL("sum of 8 (widest registers)", 8, X,
+                   mul128by128to256_sum(P, Q, 8, &X, &Y); P[0] = _mm_xor_si128(P[0], X); Q[0] = _mm_xor_si128(Q[0], Y))
+#if CLMUL_WIDE
+        __m256i X256 = _mm256_loadu_si256((const __m256i *) P), Y256 = _mm256_loadu_si256((const __m256i *) Q);
+        const __m256i A256 = _mm256_broadcastsi128_si256(A);
+        TIMEKERNEL("ymm, 2 independent products", 2, X256,
+                   mul128by128to256_si256(X256, Y256, &X256, &Y256); X256 = _mm256_xor_si256(X256, A256))
+        _mm256_storeu_si256((__m256i *) P, _mm256_xor_si256(X256, Y256));
+#if CLMUL_WIDE == 512
+        __m512i X512 = _mm512_loadu_si512((const void *) P), Y512 = _mm512_loadu_si512((const void *) Q);
+        const __m512i A512 = _mm512_broadcast_i32x4(A);
+        TIMEKERNEL("zmm, 4 independent products", 4, X512,
+                   mul128by128to256_si512(X512, Y512, &X512, &Y512); X512 = _mm512_xor_si512(X512, A512))
+        _mm512_storeu_si512((void *) P, _mm512_xor_si512(X512, Y512));
+#endif
+#endif
+        printme32(_mm_xor_si128(_mm_xor_si128(X, Y), P[0]));
+        printf("\n");
+    }
 }
 
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/time.h>
 #include <assert.h>
 #include <unistd.h>
@@ -74,6 +75,96 @@ uint64_t barrettWithoutPrecomputation64(__m128i A) {
     return _mm_cvtsi128_si64(final);
 }
 
+// one-accumulator versions of the batched reductions of clmul.h
+static inline void precompReduction64_x1(const __m128i * A, uint64_t * out) {
+    out[0] = precompReduction64(A[0]);
+}
+
+static inline void barrettWithoutPrecomputation32_x1(const __m128i * A, uint32_t * out) {
+    out[0] = barrettWithoutPrecomputation32(A[0]);
+}
+
+static inline void lazymod127_x1(const __m128i * Alow, const __m128i * Ahigh, __m128i * out) {
+    out[0] = lazymod127(Alow[0], Ahigh[0]);
+}
+
+// lazymod127 with the high halves taken 8 accumulators further, or from the input itself
+#define LAZYMOD127(WIDTH) \
+static inline void lazymod127_in_x##WIDTH(const __m128i * A, __m128i * out) { \
+    lazymod127_x##WIDTH(A, A + 8, out); \
+}
+LAZYMOD127(1)
+LAZYMOD127(2)
+LAZYMOD127(4)
+LAZYMOD127(8)
+
+static inline __m128i lazymod127_in_si128(__m128i A) {
+    return lazymod127(A, A);
+}
+#ifdef __AVX2__
+static inline __m256i lazymod127_in_si256(__m256i A) {
+    return lazymod127_si256(A, A);
+}
+#endif
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+static inline __m512i lazymod127_in_si512(__m512i A) {
+    return lazymod127_si512(A, A);
+}
+#endif
+
+// Throughput in cycles per reduction: REDUCE##_x##WIDTH over independent batches of WIDTH
+// accumulators.
+#define TIMETHROUGHPUT(REDUCE, OUTTYPE, WIDTH)                                             \
+    ({                                                                                     \
+        OUTTYPE out[8];                                                                    \
+        bef = startRDTSC();                                                                \
+        for (j = 0; j < SHORTTRIALS; ++j)                                                  \
+            for (i = 0; i + WIDTH <= howmany; i += WIDTH) {                                \
+                REDUCE##_x##WIDTH(data + i, out);                                          \
+                __asm__ volatile("" : : "r"(out) : "memory");                              \
+            }                                                                              \
+        aft = stopRDTSCP();                                                                \
+        (aft - bef) * 1.0 / (SHORTTRIALS * (howmany / WIDTH * WIDTH));                     \
+    })
+
+// Latency in cycles per batch: each register of accumulators is reduced, then xored with
+// the next ones, so that every reduction waits for the previous one.
+#define TIMELATENCY(KERNEL, TYPE, WIDTH, LOAD, XOR)                                        \
+    ({                                                                                     \
+        TYPE acc = LOAD((const void *) data);                                              \
+        bef = startRDTSC();                                                                \
+        for (j = 0; j < SHORTTRIALS; ++j)                                                  \
+            for (i = 0; i + WIDTH <= howmany; i += WIDTH)                                  \
+                acc = KERNEL(XOR(acc, LOAD((const void *) (data + i))));                   \
+        aft = stopRDTSCP();                                                                \
+        uint32_t first;                                                                    \
+        memcpy(&first, &acc, sizeof(first));                                               \
+        force_computation(first);                                                          \
+        (aft - bef) * 1.0 / (SHORTTRIALS * (howmany / WIDTH));                             \
+    })
+
+#if CLMUL_WIDE == 512
+#define LATENCIES(KERNEL)                                                                  \
+    printf("%-30s latency: %6.2f (x1), %6.2f (x2, ymm), %6.2f (x4, zmm) cycles\n", #KERNEL, \
+           TIMELATENCY(KERNEL##_si128, __m128i, 1, _mm_loadu_si128, _mm_xor_si128),        \
+           TIMELATENCY(KERNEL##_si256, __m256i, 2, _mm256_loadu_si256, _mm256_xor_si256),  \
+           TIMELATENCY(KERNEL##_si512, __m512i, 4, _mm512_loadu_si512, _mm512_xor_si512));
+#elif CLMUL_WIDE
+#define LATENCIES(KERNEL)                                                                  \
+    printf("%-30s latency: %6.2f (x1), %6.2f (x2, ymm) cycles\n", #KERNEL,                 \
+           TIMELATENCY(KERNEL##_si128, __m128i, 1, _mm_loadu_si128, _mm_xor_si128),        \
+           TIMELATENCY(KERNEL##_si256, __m256i, 2, _mm256_loadu_si256, _mm256_xor_si256));
+#else
+#define LATENCIES(KERNEL)                                                                  \
+    printf("%-30s latency: %6.2f (x1) cycles\n", #KERNEL,                                  \
+           TIMELATENCY(KERNEL##_si128, __m128i, 1, _mm_loadu_si128, _mm_xor_si128));
+#endif
+
+#define THROUGHPUTS(REDUCE, OUTTYPE)                                                       \
+    printf("%-30s throughput: %6.3f (x1), %6.3f (x2), %6.3f (x4), %6.3f (x8) cycles/reduction\n", \
+           #REDUCE, TIMETHROUGHPUT(REDUCE, OUTTYPE, 1), TIMETHROUGHPUT(REDUCE, OUTTYPE, 2), \
+           TIMETHROUGHPUT(REDUCE, OUTTYPE, 4), TIMETHROUGHPUT(REDUCE, OUTTYPE, 8));
+
 int main(int argc, char ** arg) {
     int N = 1024;
     int SHORTTRIALS = 100000;
@@ -139,5 +230,21 @@ int main(int argc, char ** arg) {
         force_computation (sumToFoolCompiler2);
     }
     printf("\n");
+#if CLMUL_WIDE
+    printf("Batched reductions, up to %d accumulators per VPCLMULQDQ register.\n",
+           CLMUL_WIDE / 128);
+#else
+    printf("Batched reductions (one accumulator at a time: no VPCLMULQDQ).\n");
+#endif
+    {
+        const __m128i * data = (const __m128i *) &intstring[0];
+        const int howmany = N / 4 - 8; // lazymod127_in reads 8 accumulators further
+        THROUGHPUTS(precompReduction64, uint64_t)
+        LATENCIES(precompReduction64)
+        THROUGHPUTS(barrettWithoutPrecomputation32, uint32_t)
+        LATENCIES(barrettWithoutPrecomputation32)
+        THROUGHPUTS(lazymod127_in, __m128i)
+        LATENCIES(lazymod127_in)
+    }
 }
 
@@ -0,0 +1,113 @@
+/**
+* Startup latency of PMP64: cycles from an unconfigured hasher to the first digest,
+* with coefficients from randomize(), from a compile-time seeded table, and through
+* the lazily built hasher of the C wrapper.
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "PMP/PMP_Multilinear_64.h"
+#include "PMP/PMP_C_wrapper.h"
+
+typedef unsigned long long ticks;
+
+// Taken from stackoverflow (see http://stackoverflow.com/questions/3830883/cpu-cycle-count-based-profiling-in-c-c-linux-x86-64)
+// Can give nonsensical results on multi-core AMD processors.
+ticks rdtsc() {
+    unsigned int lo, hi;
+    asm volatile (
+        "cpuid \n" /* serializing */
+        "rdtsc"
+        : "=a"(lo), "=d"(hi) /* outputs */
+        : "a"(0) /* inputs */
+        : "%ebx", "%ecx");
+    /* clobbers*/
+    return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+ticks startRDTSC(void) {
+    return rdtsc();
+}
+
+ticks stopRDTSCP(void) {
+    return rdtsc();
+}
+
+class XorShiftGenerator : public UniformRandomNumberGenerator {
+public:
+    XorShiftGenerator(uint32_t seed) : state(seed | 1) {}
+    uint32_t rand() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+private:
+    uint32_t state;
+};
+
+void force_computation(uint64_t forcedValue) {
+    // make sure forcedValue has to be computed, but avoid output (unless unlucky)
+    if (forcedValue % 277387 == 17)
+        printf("wow, what a coincidence! (in pmpstartupbenchmark.cc)");
+}
+
+void printusage(char * command) {
+    printf(" Usage: %s -r repeats \n", command);
+}
+
+int main(int argc, char ** arg) {
+    int HowManyRepeats = 1000;
+    int c;
+    while ((c = getopt(argc, arg, "hr:")) != -1)
+        switch (c) {
+        case 'h':
+            printusage(arg[0]);
+            return 0;
+        case 'r':
+            HowManyRepeats = atoi(optarg);
+            break;
+        default:
+            abort();
+        }
+    unsigned char key[16];
+    memset(key, 'k', sizeof(key));
+    ticks bef, aft;
+
+    // the wrapper builds its hasher on the first call only, so this is measured once
+    bef = startRDTSC();
+    force_computation(pmp64_hash(key, sizeof(key)));
+    aft = stopRDTSCP();
+    printf("first pmp64_hash call (lazy init):  %llu cycles\n", aft - bef);
+    bef = startRDTSC();
+    force_computation(pmp64_hash(key, sizeof(key)));
+    aft = stopRDTSCP();
+    printf("second pmp64_hash call:             %llu cycles\n", aft - bef);
+
+    ticks randomized = ~0ULL, seeded = ~0ULL;
+    for (int k = 0; k < HowManyRepeats; ++k) {
+        bef = startRDTSC();
+        {
+            PMP_Multilinear_Hasher_64 hasher;
+            XorShiftGenerator rng(k);
+            hasher.randomize(rng);
+            force_computation(hasher.hash(key, sizeof(key)));
+        }
+        aft = stopRDTSCP();
+        if (aft - bef < randomized) randomized = aft - bef;
+
+        bef = startRDTSC();
+        {
+            PMP_Multilinear_Hasher_64 hasher(PMPML_Seeded_Coefficients_64<UINT64_C(0x5eed)>::rd);
+            force_computation(hasher.hash(key, sizeof(key)));
+        }
+        aft = stopRDTSCP();
+        if (aft - bef < seeded) seeded = aft - bef;
+    }
+    printf("randomize() then hash (best of %d): %llu cycles\n", HowManyRepeats, randomized);
+    printf("seeded table then hash (best of %d): %llu cycles\n", HowManyRepeats, seeded);
+    return 0;
+}
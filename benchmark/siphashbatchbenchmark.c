@@ -0,0 +1,99 @@
+/**
+* SipHash-2-4 on batches of short keys: one siphash() call per key against
+* siphash_batch, which hashes 8 (AVX-512) or 4 (AVX2) keys per SIMD pass.
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef unsigned long long ticks;
+
+// Taken from stackoverflow (see http://stackoverflow.com/questions/3830883/cpu-cycle-count-based-profiling-in-c-c-linux-x86-64)
+// Can give nonsensical results on multi-core AMD processors.
+ticks rdtsc() {
+    unsigned int lo, hi;
+    asm volatile (
+        "cpuid \n" /* serializing */
+        "rdtsc"
+        : "=a"(lo), "=d"(hi) /* outputs */
+        : "a"(0) /* inputs */
+        : "%ebx", "%ecx");
+    /* clobbers*/
+    return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+ticks startRDTSC(void) {
+    return rdtsc();
+}
+
+ticks stopRDTSCP(void) {
+    return rdtsc();
+}
+
+#include "SipHash/siphash24.h"
+
+void force_computation(uint64_t forcedValue) {
+    // make sure forcedValue has to be computed, but avoid output (unless unlucky)
+    if (forcedValue % 277387 == 17)
+        printf("wow, what a coincidence! (in siphashbatchbenchmark.c)");
+}
+
+void printusage(char * command) {
+    printf(" Usage: %s ", command);
+}
+
+int main(int argc, char ** arg) {
+    const int N = 1024; // keys per batch
+    const int HowManyRepeats = 100;
+    const int lengths[] = {8, 16, 24, 32, 64, 128};
+    int c;
+    while ((c = getopt(argc, arg, "h")) != -1)
+        switch (c) {
+        case 'h':
+            printusage(arg[0]);
+            return 0;
+        default:
+            abort();
+        }
+    uint8_t key[16];
+    for (int i = 0; i < 16; ++i) key[i] = (uint8_t) rand();
+    uint8_t * storage = (uint8_t *) malloc(N * 128);
+    for (int i = 0; i < N * 128; ++i) storage[i] = (uint8_t) rand();
+    const uint8_t ** in = (const uint8_t **) malloc(N * sizeof(uint8_t *));
+    uint64_t * inlen = (uint64_t *) malloc(N * sizeof(uint64_t));
+    uint64_t * out = (uint64_t *) malloc(N * sizeof(uint64_t));
+    printf("Reporting the number of cycles per key (best of %d batches of %d keys).\n", HowManyRepeats, N);
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l) {
+        for (int i = 0; i < N; ++i) {
+            in[i] = storage + i * 128;
+            inlen[i] = lengths[l];
+        }
+        ticks bestsingle = ~0ULL, bestbatch = ~0ULL;
+        for (int k = 0; k < HowManyRepeats; ++k) {
+            uint64_t sum = 0;
+            ticks bef = startRDTSC();
+            for (int i = 0; i < N; ++i) {
+                uint64_t digest;
+                siphash((uint8_t *) &digest, in[i], inlen[i], key);
+                sum += digest;
+            }
+            ticks aft = stopRDTSCP();
+            force_computation(sum);
+            if (aft - bef < bestsingle) bestsingle = aft - bef;
+            bef = startRDTSC();
+            siphash_batch(out, in, inlen, N, key);
+            aft = stopRDTSCP();
+            force_computation(out[N - 1]);
+            if (aft - bef < bestbatch) bestbatch = aft - bef;
+        }
+        printf("%3d-byte keys: siphash %6.1f cycles/key, siphash_batch %6.1f cycles/key\n",
+               lengths[l], (double) bestsingle / N, (double) bestbatch / N);
+    }
+    free(storage);
+    free(in);
+    free(inlen);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,119 @@
+/////////////////////////////////////
+// Cycles per byte of the 128-bit hash functions as the input length grows,
+// in the same format as variablelengthbenchmark.cc.
+/////////////////////////////////////
+
+//
+// this code will hash strings of 64-bit characters. To use on
+// strings of 8-bit characters, you may need some adequate padding.
+//
+#include <cassert>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <iostream>
+
+using namespace std;
+
+#ifdef __AVX__
+#define __PCLMUL__ 1
+#endif
+
+
+extern "C" {
+#include "timers.h"
+
+#include "hashfunctions128bits.h"
+}
+
+struct NamedFunc128 {
+  const hashFunction128 f;
+  const string name;
+  NamedFunc128(const hashFunction128& f, const string& name) : f(f), name(name) {}
+};
+
+#define NAMED(f) NamedFunc128(f, #f)
+
+NamedFunc128 hashFunctions[] = {
+    NAMED(&hashCity128),
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    NAMED(&hashCityCrc128),
+#endif
+#ifdef __PCLMUL__
+    NAMED(&GHASH128bit),
+    NAMED(&GHASH128bit8way),
+#endif
+};
+
+const int HowManyFunctions128 =
+    sizeof(hashFunctions) / sizeof(hashFunctions[0]);
+
+int main(int c, char ** arg) {
+    uint64_t which_algos = ~0;
+    assert(HowManyFunctions128 <= 64);
+    if (c > 1) {
+      if (1 != sscanf(arg[1], "%" SCNu64, &which_algos)) {
+        return 1;
+      }
+    }
+    int lengthStart = 1, lengthEnd = 2048; // inclusive
+    if (c > 2)
+        lengthStart = atoi(arg[2]);
+    if (c > 3)
+        lengthEnd = atoi(arg[3]);
+
+    int i, j;
+    int length;
+    int SHORTTRIALS;
+    uint64_t randbuffer[150] __attribute__ ((aligned (32)));// 150 should be plenty
+    uint64_t sumToFoolCompiler = 0;
+    uint64_t * intstring;
+    if (posix_memalign((void **)(&intstring), 32, sizeof(uint64_t)*(lengthEnd + 1))) {
+      cerr << "Failed to allocate " << lengthEnd + 1 << " words." << endl;
+      return 1;
+    }
+    for (i = 0; i < 150; ++i) {
+      const uint64_t seed = rand() | ((uint64_t)(rand()) << 32);
+      randbuffer[i] = seed;
+    }
+    for (i = 0; i < lengthEnd; ++i) {
+      intstring[i] = rand() | ((uint64_t)(rand()) << 32);
+    }
+
+    printf("#Reporting the number of cycles per byte.\n");
+    printf("#First number is input length in  8-byte words.\n");
+    printf("0 ");
+    for (i = 0; i < HowManyFunctions128; ++i) {
+        if (which_algos & (0x1ull << i))
+          cout << '"' << hashFunctions[i].name << "\" ";
+    }
+    printf("\n");
+    fflush(stdout);
+    for (length = lengthStart; length <= lengthEnd; length += 1) {
+        SHORTTRIALS = 8000000 / length;
+        printf("%8d \t\t", length);
+
+        for (i = 0; i < HowManyFunctions128; ++i) {
+            if (!(which_algos & (0x1ull << i)))
+                continue;  // skip unselected algos
+            const hashFunction128 thisfunc128 = hashFunctions[i].f;
+            __m128i answer = thisfunc128(randbuffer, intstring, length); // we do not count the first one
+            sumToFoolCompiler += _mm_cvtsi128_si64(answer) ^ _mm_extract_epi64(answer, 1);
+            const ticks bef = startRDTSC();
+            for (j = 0; j < SHORTTRIALS; ++j) {
+                answer = thisfunc128(randbuffer, intstring, length);
+                sumToFoolCompiler += _mm_cvtsi128_si64(answer) ^ _mm_extract_epi64(answer, 1);
+            }
+            const ticks aft = stopRDTSCP();
+            printf(" %.3f ", ((aft-bef) * 1.0)/(8.0 * SHORTTRIALS * length));
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    free(intstring);
+    printf("# ignore this #%" PRIu64 "\n", sumToFoolCompiler);
+
+}
@@ -37,6 +37,7 @@ extern "C" {
 #include "ghash.h"
 #include "umash/umash.h"
 }
+#include "bigendianuniversal.h"
 
 #include "treehash/binary-treehash.hh"
 #include "treehash/generic-treehash.hh"
@@ -66,15 +67,26 @@ uint64_t clhashWrap(const void *rs, const uint64_t *stringword, const size_t len
 NamedFunc hashFunctions[] = {
     // From the 2015 paper:
     NAMED(&hashVHASH64), NAMED(&CLHASH), NAMED(&hashCity), NAMED(&hashSipHash),
-    NAMED(&GHASH64bit),
+    NAMED(&hashSipHash13), NAMED(&hashHalfSipHash64),
+    NAMED(&GHASH64bit), NAMED(&GHASH64bit8way),
+    NAMED(&POLYVAL64bit), NAMED(&CLMULPoly64x8),
     // Tree hashing:
     NAMED((&generic_treehash<BoostedZeroCopyGenericBinaryTreehash, CLNH, 7>)),
     NAMED((&generic_treehash<BoostedZeroCopyGenericBinaryTreehash, NHCL, 7>)),
     NAMED((&generic_treehash<BoostedZeroCopyGenericBinaryTreehash, NH, 7>)),
     NAMED((&generic_treehash<BoostedZeroCopyGenericBinaryTreehash, NHavx, 3>)),
     NAMED((&hashPMP64)),
+    NAMED((&hashPMP32_64)),
+    NAMED((&hashPMP64out32_64)),
     NAMED(&umashWrap),
     NAMED(&clhashWrap),
+    // Unroll depths of the big-endian families, and the depth picked per length range:
+    NAMED(&unrolledHorner<3>), NAMED(&unrolledHorner<4>), NAMED(&unrolledHorner<5>),
+    NAMED(&unrolledHorner<6>), NAMED(&unrolledHorner<7>), NAMED(&unrolledHorner<8>),
+    NAMED(&unrolledHorner<9>), NAMED(&unrolledHornerSelected),
+    NAMED(&iterateCL<8>), NAMED(&iterateCL<9>), NAMED(&iterateCL<10>),
+    NAMED(&iterateCL<11>), NAMED(&iterateCL<12>), NAMED(&iterateCLSelected),
+    NAMED(&treeCL<8>), NAMED(&treeCL<9>), NAMED(&treeCL<10>), NAMED(&treeCLSelected),
 };
 
 const int HowManyFunctions64 =
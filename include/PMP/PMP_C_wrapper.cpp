@@ -2,7 +2,16 @@
 #include "PMP_Multilinear_64.h"
 #include "PMP_C_wrapper.h"
 
-static PMP_Multilinear_Hasher_64 pmp64;
+// Built on first use (thread-safe since C++11), so loading the library runs no initializer.
+// Define PMPML_COEFFICIENT_SEED_64 to hash with a compile-time table generated from that seed.
+static const PMP_Multilinear_Hasher_64& pmp64_hasher() {
+#ifdef PMPML_COEFFICIENT_SEED_64
+    static const PMP_Multilinear_Hasher_64 pmp64( PMPML_Seeded_Coefficients_64<PMPML_COEFFICIENT_SEED_64>::rd );
+#else
+    static const PMP_Multilinear_Hasher_64 pmp64;
+#endif
+    return pmp64;
+}
 
 
 #ifdef __cplusplus
@@ -13,7 +22,12 @@ extern "C" {
 
 /* Hash the string made of length characters, returns a 64-bit value.*/
 uint64_t pmp64_hash( const unsigned char* chars, size_t length) {
-    return pmp64.hash(chars,length);
+    return pmp64_hasher().hash(chars,length);
+}
+
+/* Same value as pmp64_hash, using up to threads threads on long strings.*/
+uint64_t pmp64_hash_parallel( const unsigned char* chars, size_t length, unsigned int threads) {
+    return pmp64_hasher().hash_parallel(chars,length,threads);
 }
 
 
@@ -5,6 +5,9 @@
 /*
 C interface to the PMP library.
 
+pmp32_hash is PMP+-Multilinear with 32-bit words and a 32-bit output;
+pmp64out32_hash computes the same family with 64-bit arithmetic.
+
 TODO: implement seeding and 64-bit hashing
 */
 #ifdef __cplusplus
@@ -14,6 +17,15 @@ extern "C" {
 /* Hash the string made of length characters, returns a 64-bit value.*/
 uint64_t pmp64_hash( const unsigned char* chars, size_t length);
 
+/* Same value as pmp64_hash, using up to threads threads on long strings.*/
+uint64_t pmp64_hash_parallel( const unsigned char* chars, size_t length, unsigned int threads);
+
+/* Hash the string made of length characters, returns a 32-bit value.*/
+uint32_t pmp32_hash( const unsigned char* chars, size_t length);
+
+/* Hash the string made of length characters, returns a 32-bit value.*/
+uint32_t pmp64out32_hash( const unsigned char* chars, size_t length);
+
 
 
 #ifdef __cplusplus
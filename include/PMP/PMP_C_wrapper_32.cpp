@@ -0,0 +1,22 @@
+
+#include "PMP_Multilinear.h"
+#include "PMP_C_wrapper.h"
+
+static PMP_Multilinear_Hasher pmp32;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/* Hash the string made of length characters, returns a 32-bit value.*/
+uint32_t pmp32_hash( const unsigned char* chars, size_t length) {
+    return pmp32.hash(chars,length);
+}
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,22 @@
+
+#include "PMP_Multilinear_64_out_32.h"
+#include "PMP_C_wrapper.h"
+
+static PMP_Multilinear_Hasher_64_out_32 pmp64out32;
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+/* Hash the string made of length characters, returns a 32-bit value.*/
+uint32_t pmp64out32_hash( const unsigned char* chars, size_t length) {
+    return pmp64out32.hash(chars,length);
+}
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -274,8 +274,7 @@ void mul32x32to64addto96(uint32_t& loWord, uint32_t& hiWord, uint32_t& hhWord, u
 
 #define PMPML_CHUNK_LOOP_INTRO_L0 \
 	uint32_t ctr; \
-	ctr = 0; \
-	ULARGE_INTEGER__XX mul;
+	ctr = 0;
 
 #ifdef _MSC_VER
 
@@ -774,16 +773,13 @@ private:
 #elif PMPML_USE_SSE_SIZE == 256
 // DANIEL: Code below will fail to compile on a machine with no AVX2 support, or without the right
 // -march flag. Please consider testing whether AVX2 is supported, e.g., see http://stackoverflow.com/questions/25820290/how-verify-that-operating-system-support-avx2-instructions
-        __m256i ctr0, ctr1, mask_low;
+        __m256i ctr0, ctr1;
         __m256i a, data, product, temp;
-        uint64_t temp_fin;
         int i;
 
         ctr0 = _mm256_setzero_si256 (); // Sets the 128-bit value to zero.
         ctr1 = _mm256_setzero_si256 ();
-        mask_low = _mm256_set_epi32 ( 0, -1, 0 , -1, 0, -1, 0 , -1 );
 
-        uint32_t *x1, *x2, *x3, *c1, *c2, *c3;
 
 #if (PMPML_CHUNK_SIZE >= 64)
         for ( i=0; i<PMPML_CHUNK_SIZE; i+=64 )
@@ -1100,7 +1096,7 @@ private:
         ctr1 = _mm_setzero_si128 ();
         mask_low = _mm_set_epi32 ( 0, -1, 0 , -1 );
 
-        for ( i=0; i<(size&0xFFFFFFF8); i+=4 )
+        for ( i=0; i<(int)(size&0xFFFFFFF8); i+=4 )
         {
             a = _mm_load_si128 ((__m128i *)(coeff+i)); // Loads 128-bit value. Address p must be 16-byte aligned.
             data = _mm_loadu_si128 ((__m128i *)(x+i)); // Loads 128-bit value. Address p does not need be 16-byte aligned.
@@ -1555,9 +1551,9 @@ private:
         else
         {
             for ( i=0; i<count; i++ )
-                PMPML_CHUNK_LOOP_BODY_ULI_T1( 0 + i )
-                for ( ; i<PMPML_CHUNK_SIZE; i++ )
-                    c_ctr.QuadPart += coeff[ i ];
+                { PMPML_CHUNK_LOOP_BODY_ULI_T1( 0 + i ) }
+            for ( ; i<PMPML_CHUNK_SIZE; i++ )
+                c_ctr.QuadPart += coeff[ i ];
         }
 
         ULARGE_INTEGER__XX lowProduct;
@@ -2125,7 +2121,6 @@ public:
 
     NOINLINE uint32_t _hash_noRecursionNoInline_forLessThanChunk(const unsigned char* chars, unsigned int cnt) const
     {
-        unsigned int i;
         ULARGE_INTEGER__XX tmp_hash;
 #if !defined PMPML_STRICT_UNALIGNED_HANDLING
         tmp_hash.QuadPart = hash_of_beginning_of_string_chunk_type2( curr_rd[0].random_coeff, *(ULARGE_INTEGER__XX*)(&(curr_rd[0].const_term)), chars, cnt );
@@ -39,9 +39,13 @@
 
 
 #include "PMP_Multilinear_common.h"
-#ifdef PMPML_USE_SSE_64
+#if defined PMPML_USE_SSE_64 || defined PMPML_USE_AVX512_64
 #include <immintrin.h>
 #endif
+#include "../avx512diagnostics.h"
+#include <system_error>
+#include <thread>
+#include <vector>
 
 
 
@@ -83,6 +87,71 @@ void MultiplyWordLoHi(uint64_t& rlo, uint64_t& rhi, uint64_t a, uint64_t b)
 	lo = (uint32_t)lo; \
 }
 
+// adds sums of 32x32 partial products (low*low, cross, high*high; each kept as
+// a sum of full products and a sum of their upper halves) to ctr0:ctr1:ctr2
+#define PMPML_ADD_PARTIAL_PRODUCT_SUMS_64( t0_0, t0_1, t1, t2, t3_0, t3_1 ) \
+{ \
+	ADD_SHIFT_ADD_NORMALIZE_TO_UPPER( t0_0, t0_1 ) \
+	ADD_SHIFT_ADD_NORMALIZE_TO_UPPER( t1, t2 ) \
+	ADD_SHIFT_ADD_NORMALIZE_TO_UPPER( t3_0, t3_1 ) \
+	uint64_t add_sse1, add_sse2; \
+	t1 += t0_1; \
+	add_sse1 = t0_0 + ( ((uint64_t)(uint32_t)t1) << 32 ); \
+	ctr0.QuadPart += add_sse1; \
+	add_sse2 = ctr0.QuadPart < add_sse1; \
+	t2 += t3_0 + (t1>>32); \
+	t3_1 += t2>>32; \
+	add_sse2 += (uint32_t)t2 + ( ( (uint64_t)(uint32_t)t3_1 ) << 32 ); \
+	ctr1.QuadPart += add_sse2; \
+	ctr2.QuadPart += (t3_1 >> 32) + (ctr1.QuadPart < add_sse2); \
+}
+
+#ifdef PMPML_USE_AVX512_64
+
+// 8 words x[i..i+7] times 8 coefficients; _mm512_mul_epu32 only reads the lower
+// 32 bits of each lane, so no masking is needed for the low halves, and the
+// upper halves are moved down with a shuffle (port 5) rather than a shift (port 0,
+// already busy with the multiplications)
+#define PMPML_CHUNK_LOOP_BODY_AVX512_64( xv, i ) \
+{ \
+	__m512i a = _mm512_loadu_si512( (const void*)(coeff + (i)) ); \
+	__m512i a_shifted = _mm512_shuffle_epi32( a, _MM_PERM_DDBB ); \
+	__m512i data_shifted = _mm512_shuffle_epi32( (xv), _MM_PERM_DDBB ); \
+	__m512i product = _mm512_mul_epu32( (xv), a ); \
+	avx_ctr0_0 = _mm512_add_epi64( avx_ctr0_0, product ); \
+	avx_ctr0_1 = _mm512_add_epi64( avx_ctr0_1, _mm512_srli_epi64( product, 32 ) ); \
+	product = _mm512_mul_epu32( (xv), a_shifted ); \
+	avx_ctr1 = _mm512_add_epi64( avx_ctr1, product ); \
+	avx_ctr2 = _mm512_add_epi64( avx_ctr2, _mm512_srli_epi64( product, 32 ) ); \
+	product = _mm512_mul_epu32( data_shifted, a ); \
+	avx_ctr1 = _mm512_add_epi64( avx_ctr1, product ); \
+	avx_ctr2 = _mm512_add_epi64( avx_ctr2, _mm512_srli_epi64( product, 32 ) ); \
+	product = _mm512_mul_epu32( data_shifted, a_shifted ); \
+	avx_ctr3_0 = _mm512_add_epi64( avx_ctr3_0, product ); \
+	avx_ctr3_1 = _mm512_add_epi64( avx_ctr3_1, _mm512_srli_epi64( product, 32 ) ); \
+}
+
+#define PMPML_CHUNK_LOOP_INTRO_AVX512_64 \
+	__m512i avx_ctr0_0 = _mm512_setzero_si512(); \
+	__m512i avx_ctr0_1 = _mm512_setzero_si512(); \
+	__m512i avx_ctr1 = _mm512_setzero_si512(); \
+	__m512i avx_ctr2 = _mm512_setzero_si512(); \
+	__m512i avx_ctr3_0 = _mm512_setzero_si512(); \
+	__m512i avx_ctr3_1 = _mm512_setzero_si512();
+
+#define PMPML_CHUNK_LOOP_OUTRO_AVX512_64 \
+{ \
+	uint64_t t0_0 = _mm512_reduce_add_epi64( avx_ctr0_0 ); \
+	uint64_t t0_1 = _mm512_reduce_add_epi64( avx_ctr0_1 ); \
+	uint64_t t1 = _mm512_reduce_add_epi64( avx_ctr1 ); \
+	uint64_t t2 = _mm512_reduce_add_epi64( avx_ctr2 ); \
+	uint64_t t3_0 = _mm512_reduce_add_epi64( avx_ctr3_0 ); \
+	uint64_t t3_1 = _mm512_reduce_add_epi64( avx_ctr3_1 ); \
+	PMPML_ADD_PARTIAL_PRODUCT_SUMS_64( t0_0, t0_1, t1, t2, t3_0, t3_1 ) \
+}
+
+#endif // PMPML_USE_AVX512_64
+
 
 ////    DECLARATIONS    ////
 ////////////////////////////
@@ -167,7 +236,7 @@ __asm__( "mulq %5\n" \
         "adcq %%rdx, %1\n" \
         "adcq $0, %2\n" \
         : "+g" (ctr0.QuadPart), "+g" (ctr1.QuadPart), "+g" (ctr2.QuadPart), "=a" (rhi) \
-        :"a"(x[i]), "g"(coeff[ i ]) : "rdx", "cc" ); \
+        :"a"(x[i]), "rm"(coeff[ i ]) : "rdx", "cc" ); \
 }
 #endif  // __clang__
 
@@ -184,7 +253,7 @@ __asm__( "mulq %5\n" \
         "adcq %%rdx, %1\n" \
         "adcq $0, %2\n" \
         : "+g" (ctr2_0), "+g" (ctr2_1), "+g" (ctr2_2), "=a" (rhi) \
-        :"a"(x[ii]), "g"(coeff[ ii ]) : "rdx", "cc" ); \
+        :"a"(x[ii]), "rm"(coeff[ ii ]) : "rdx", "cc" ); \
 }
 
 #define compensate { \
@@ -297,7 +366,7 @@ __asm__( "mulq %5\n" \
         "adcq %%rdx, %1\n" \
         "adcq $0, %2\n" \
         : "+g" (ctr0.QuadPart), "+g" (ctr1.QuadPart), "+g" (ctr2.QuadPart), "=a" (rhi) \
-        :"a"(xLast), "g"(coeff[size]) : "rdx", "cc" ); \
+        :"a"(xLast), "rm"(coeff[size]) : "rdx", "cc" ); \
 }
 #endif // __clang__
 
@@ -311,7 +380,7 @@ __asm__( "mulq %5\n" \
         "adcq %%rdx, %1\n" \
         "adcq $0, %2\n" \
         : "+g" (ctr0.QuadPart), "+g" (ctr1.QuadPart), "+g" (ctr2.QuadPart), "=a" (rhi) \
-        :"a"(x[i].LowPart), "g"(coeff[i]) : "rdx", "cc" ); \
+        :"a"(x[i].LowPart), "rm"(coeff[i]) : "rdx", "cc" ); \
 	} \
 	else \
 	{ \
@@ -331,14 +400,14 @@ __asm__("addq %3, %0\n" \
 __asm("addq %2, %0\n" \
       "adcq $0, %1\n" \
       : "+g" (c_ctr0.QuadPart), "+g" (c_ctr1.QuadPart) \
-      : "g" (coeff[i]) : "cc", "memory" );}
+      : "rm" (coeff[i]) : "cc", "memory" );}
 
 #define PMPML_CHUNK_LOOP_BODY_ULI_T2_AND_ADD_COEFF_64( i ) \
 { \
 __asm("addq %2, %0\n" \
       "adcq $0, %1\n" \
       : "+g" (c_ctr0.QuadPart), "+g" (c_ctr1.QuadPart) \
-      : "g" (coeff[i]) : "cc", "memory" ); \
+      : "rm" (coeff[i]) : "cc", "memory" ); \
 	if ( _LIKELY_BRANCH_( x[ i ].HighPart == 0 ) ) \
 	{ \
 uint64_t rhi;  /*Dummy variable to tell the compiler that the register rax is input and clobbered but not actually output; see assembler code below. Better syntactic expression is very welcome.*/ \
@@ -347,7 +416,7 @@ __asm__( "mulq %5\n" \
         "adcq %%rdx, %1\n" \
         "adcq $0, %2\n" \
         : "+g" (ctr0.QuadPart), "+g" (ctr1.QuadPart), "+g" (ctr2.QuadPart), "=a" (rhi) \
-        :"a"(x[i].LowPart), "g"(coeff[i]) : "rdx", "cc" ); \
+        :"a"(x[i].LowPart), "rm"(coeff[i]) : "rdx", "cc" ); \
 	} \
 	else \
 	{ \
@@ -368,12 +437,12 @@ __asm__( "mulq %5\n" \
         "adcq %%rdx, %1\n" \
         "adcq $0, %2\n" \
         : "+g" (ctr0.QuadPart), "+g" (ctr1.QuadPart), "+g" (ctr2.QuadPart), "=a" (rhi) \
-        :"a"(c_ctr0.QuadPart), "g"(prevConstTerm) : "rdx", "cc" ); \
+        :"a"(c_ctr0.QuadPart), "rm"(prevConstTerm) : "rdx", "cc" ); \
 __asm__( "mulq %4\n" \
         "addq %%rax, %0\n" \
         "adcq %%rdx, %1\n" \
         : "+g" (ctr1.QuadPart), "+g" (ctr2.QuadPart), "=a" (rhi) \
-        :"a"(c_ctr1.QuadPart), "g"(prevConstTerm) : "rdx", "cc" ); \
+        :"a"(c_ctr1.QuadPart), "rm"(prevConstTerm) : "rdx", "cc" ); \
 }
 
 #endif // _MSC_VER
@@ -457,6 +526,73 @@ __asm__( "mulq %4\n" \
 
 
 
+////   COMPILE-TIME COEFFICIENTS    ////
+////////////////////////////////////////
+
+// PMPML_Seeded_Coefficients_64<Seed>::rd is a full coefficient table generated by the compiler
+// from Seed (splitmix64 stream, invalid values rejected as in randomize()); it lives in read-only
+// data, so a hasher built on it costs nothing at startup
+
+constexpr uint64_t pmpml_splitmix64_final( uint64_t z ) { return z ^ ( z >> 31 ); }
+constexpr uint64_t pmpml_splitmix64_round2( uint64_t z ) { return pmpml_splitmix64_final( ( z ^ ( z >> 27 ) ) * UINT64_C( 0x94d049bb133111eb ) ); }
+constexpr uint64_t pmpml_splitmix64_round1( uint64_t z ) { return pmpml_splitmix64_round2( ( z ^ ( z >> 30 ) ) * UINT64_C( 0xbf58476d1ce4e5b9 ) ); }
+constexpr uint64_t pmpml_seeded_word_64( uint64_t seed, uint64_t n ) { return pmpml_splitmix64_round1( seed + ( n + 1 ) * UINT64_C( 0x9e3779b97f4a7c15 ) ); }
+
+constexpr uint64_t pmpml_seeded_coeff_64( uint64_t seed, int level, int j, uint64_t attempt = 0 )
+{
+    return IS_VALID_COEFFICIENT_64( pmpml_seeded_word_64( seed, ( (uint64_t)( level * PMPML_CHUNK_SIZE_64 + j ) << 8 ) + attempt ), level ) ?
+           pmpml_seeded_word_64( seed, ( (uint64_t)( level * PMPML_CHUNK_SIZE_64 + j ) << 8 ) + attempt ) :
+           pmpml_seeded_coeff_64( seed, level, j, attempt + 1 );
+}
+
+constexpr uint64_t pmpml_seeded_const_term_64( uint64_t seed, int level )
+{
+    return pmpml_seeded_word_64( seed, (uint64_t)( PMPML_LEVELS_64 * PMPML_CHUNK_SIZE_64 + level ) << 8 );
+}
+
+// 128-bit sum of coefficients j..PMPML_CHUNK_SIZE_64-1 added to { lo, hi }
+constexpr ULARGELARGE_INTEGER__XX pmpml_seeded_sum_64( uint64_t seed, int level, int j, uint64_t lo, uint64_t hi )
+{
+    return j == PMPML_CHUNK_SIZE_64 ? ULARGELARGE_INTEGER__XX{ lo, hi } :
+           pmpml_seeded_sum_64( seed, level, j + 1, lo + pmpml_seeded_coeff_64( seed, level, j ),
+                                hi + ( lo + pmpml_seeded_coeff_64( seed, level, j ) < lo ? 1 : 0 ) );
+}
+
+template<int... I> struct pmpml_index_list_64 {};
+template<int N, int... I> struct pmpml_make_index_list_64 : pmpml_make_index_list_64<N - 1, N - 1, I...> {};
+template<int... I> struct pmpml_make_index_list_64<0, I...>
+{
+    typedef pmpml_index_list_64<I...> type;
+};
+
+template<uint64_t Seed, int... J>
+constexpr random_data_for_PMPML_64 pmpml_seeded_level_64( int level, pmpml_index_list_64<J...> )
+{
+    return random_data_for_PMPML_64{ pmpml_seeded_const_term_64( Seed, level ),
+                                     pmpml_seeded_sum_64( Seed, level, 0, 0, 0 ).LowPart,
+                                     pmpml_seeded_sum_64( Seed, level, 0, 0, 0 ).HighPart,
+                                     0, // dummy
+                                     { pmpml_seeded_coeff_64( Seed, level, J )... } };
+}
+
+template<uint64_t Seed, class Levels = typename pmpml_make_index_list_64<PMPML_LEVELS_64>::type>
+struct PMPML_Seeded_Coefficients_64;
+
+template<uint64_t Seed, int... L>
+struct PMPML_Seeded_Coefficients_64<Seed, pmpml_index_list_64<L...> >
+{
+    static constexpr random_data_for_PMPML_64 rd[ PMPML_LEVELS_64 ] =
+    {
+        pmpml_seeded_level_64<Seed>( L, typename pmpml_make_index_list_64<PMPML_CHUNK_SIZE_64>::type() )...
+    };
+};
+
+template<uint64_t Seed, int... L>
+constexpr random_data_for_PMPML_64 PMPML_Seeded_Coefficients_64<Seed, pmpml_index_list_64<L...> >::rd[ PMPML_LEVELS_64 ];
+
+
+
+
 ////   EXECUTION LOGIC    ////
 //////////////////////////////
 
@@ -465,8 +601,10 @@ class PMP_Multilinear_Hasher_64
 {
 private:
     const random_data_for_PMPML_64* curr_rd;
+    bool curr_rd_owned; // set when curr_rd was allocated by randomize()
 
     // calls to be done from LEVEL=0
+AVX512_KERNELS_BEGIN
     FORCE_INLINE void hash_of_string_chunk_compact( const uint64_t* coeff, ULARGE_INTEGER__XX constTerm, const uint64_t* x, ULARGELARGE_INTEGER__XX& ret ) const
     {
         PMPML_CHUNK_LOOP_INTRO_L0_64
@@ -584,25 +722,7 @@ private:
         t3_0 = ((uint64_t*)(&sse_ctr3_0))[0] + ((uint64_t*)(&sse_ctr3_0))[1] + ((uint64_t*)(&sse_ctr3_0))[2] + ((uint64_t*)(&sse_ctr3_0))[3];
         t3_1 = ((uint64_t*)(&sse_ctr3_1))[0] + ((uint64_t*)(&sse_ctr3_1))[1] + ((uint64_t*)(&sse_ctr3_1))[2] + ((uint64_t*)(&sse_ctr3_1))[3];
 
-        ADD_SHIFT_ADD_NORMALIZE_TO_UPPER( t0_0, t0_1 )
-        ADD_SHIFT_ADD_NORMALIZE_TO_UPPER( t1, t2 )
-        ADD_SHIFT_ADD_NORMALIZE_TO_UPPER( t3_0, t3_1 )
-
-        uint64_t add_sse1, add_sse2;
-
-        t1 += t0_1;
-        add_sse1 = t0_0 + ( ((uint64_t)(uint32_t)t1) << 32 );
-        ctr0.QuadPart += add_sse1;
-        add_sse2 = ctr0.QuadPart < add_sse1;
-
-        t2 += t3_0 + (t1>>32);
-        t3_1 += t2>>32;
-
-        add_sse2 += (uint32_t)t2 + ( ( (uint64_t)(uint32_t)t3_1 ) << 32 );
-        ctr1.QuadPart += add_sse2;
-
-        ctr2.QuadPart += (t3_1 >> 32) + (ctr1.QuadPart < add_sse2);
-
+        PMPML_ADD_PARTIAL_PRODUCT_SUMS_64( t0_0, t0_1, t1, t2, t3_0, t3_1 )
 
 #elif (PMPML_CHUNK_OPTIMIZATION_TYPE_64 == 2)
 #error Not yet implemented
@@ -610,6 +730,21 @@ private:
 #error unxpected PMPML_CHUNK_OPTIMIZATION_TYPE_64
 #endif
 
+#elif defined PMPML_USE_AVX512_64
+
+#if ( PMPML_CHUNK_SIZE_64 < 8 )
+#error PMPML_USE_AVX512_64 is incompatible with PMPML_CHUNK_SIZE_64 < 8 in a current implementation
+#endif
+        PMPML_CHUNK_LOOP_INTRO_AVX512_64
+
+        for ( uint64_t i=0; i<(PMPML_CHUNK_SIZE_64); i+=8 )
+        {
+            __m512i data = _mm512_loadu_si512( (const void*)(x + i) );
+            PMPML_CHUNK_LOOP_BODY_AVX512_64( data, i )
+        }
+
+        PMPML_CHUNK_LOOP_OUTRO_AVX512_64
+
 #else // PMPML_USE_SSE_64
 
         for ( uint64_t i=0; i<(PMPML_CHUNK_SIZE_64); i+=32 )
@@ -661,6 +796,7 @@ private:
         ret.LowPart = ctr0.QuadPart;
         ret.HighPart = ctr1.QuadPart;
     }
+AVX512_KERNELS_END
 
     FORCE_INLINE void hash_of_beginning_of_string_chunk_short_type2( const uint64_t* coeff, ULARGE_INTEGER__XX constTerm, const unsigned char* tail, std::size_t tail_size, ULARGELARGE_INTEGER__XX& ret ) const
     {
@@ -859,12 +995,39 @@ private:
     }
 
     // a call to be done from subsequent levels
+AVX512_KERNELS_BEGIN
     FORCE_INLINE void hash_of_num_chunk( const uint64_t* coeff, ULARGE_INTEGER__XX constTerm, const ULARGELARGE_INTEGER__XX* x, ULARGELARGE_INTEGER__XX& ret ) const
     {
         ULARGE_INTEGER__XX ctr0, ctr1, ctr2;
         ctr0.QuadPart = constTerm.QuadPart;
         ctr1.QuadPart = 0;
         ctr2.QuadPart = 0;
+
+#ifdef PMPML_USE_AVX512_64
+
+        // values of lower levels are reduced modulo 2^64+13, so that HighPart is either 0 or 1
+        // and x[i]*coeff[i] = LowPart*coeff[i] + (HighPart ? coeff[i] << 64 : 0)
+        const __m512i idx_low = _mm512_set_epi64( 14, 12, 10, 8, 6, 4, 2, 0 );
+        const __m512i idx_high = _mm512_set_epi64( 15, 13, 11, 9, 7, 5, 3, 1 );
+        PMPML_CHUNK_LOOP_INTRO_AVX512_64
+
+        for ( uint64_t i=0; i<(PMPML_CHUNK_SIZE_64); i+=8 )
+        {
+            __m512i x0 = _mm512_loadu_si512( (const void*)(x + i) );
+            __m512i x1 = _mm512_loadu_si512( (const void*)(x + i + 4) );
+            __m512i data = _mm512_permutex2var_epi64( x0, idx_low, x1 );
+            __m512i data_high = _mm512_permutex2var_epi64( x0, idx_high, x1 );
+            __mmask8 has_high = _mm512_test_epi64_mask( data_high, data_high );
+            PMPML_CHUNK_LOOP_BODY_AVX512_64( data, i )
+            __m512i c = _mm512_loadu_si512( (const void*)(coeff + i) );
+            avx_ctr3_0 = _mm512_mask_add_epi64( avx_ctr3_0, has_high, avx_ctr3_0, c );
+            avx_ctr3_1 = _mm512_mask_add_epi64( avx_ctr3_1, has_high, avx_ctr3_1, _mm512_srli_epi64( c, 32 ) );
+        }
+
+        PMPML_CHUNK_LOOP_OUTRO_AVX512_64
+
+#else // PMPML_USE_AVX512_64
+
         ULARGE_INTEGER__XX mulLow, mulHigh;
 
         for ( uint64_t i=0; i<(PMPML_CHUNK_SIZE_64); i+=32 )
@@ -909,12 +1072,15 @@ private:
 #endif
         }
 
+#endif // PMPML_USE_AVX512_64
+
         PMPML_CHUNK_REDUCE_128_TO_64
 
 
         ret.LowPart = ctr0.QuadPart;
         ret.HighPart = ctr1.QuadPart;
     }
+AVX512_KERNELS_END
 
     // a call to be done from subsequent levels
     FORCE_INLINE void hash_of_num_chunk_incomplete( const uint64_t* coeff, uint64_t constTerm, uint64_t prevConstTerm, uint64_t coeffSumLow, uint64_t coeffSumHigh, const ULARGELARGE_INTEGER__XX* x, size_t count, ULARGELARGE_INTEGER__XX& ret ) const
@@ -1140,6 +1306,12 @@ public:
             hash_of_string_chunk_compact( curr_rd[0].random_coeff, *(ULARGE_INTEGER__XX*)(&(curr_rd[0].const_term)), ((const uint64_t*)(chars)) + ( i << PMPML_CHUNK_SIZE_LOG2_64 ), tmp_hash );
             procesNextValue( 1, tmp_hash, allValues, cnts, flag );
         }
+        return hash_of_tail_and_finalize_type2( chars, cnt, allValues, cnts, flag );
+    }
+
+    FORCE_INLINE uint64_t hash_of_tail_and_finalize_type2( const unsigned char* chars, std::size_t cnt, _ULARGELARGE_INTEGER__XX * allValues, std::size_t * cnts, std::size_t& flag ) const
+    {
+        _ULARGELARGE_INTEGER__XX tmp_hash;
         // process remaining incomplete chunk(s)
         // note: if string size is a multiple of chunk size, we create a new chunk (1,0,0,...0),
         // so THIS PROCESSING IS ALWAYS PERFORMED
@@ -1155,15 +1327,91 @@ public:
         return finRet.LowPart;
     }
 
+    // hashes chunks [first, last) of level 0 into values[ 0 .. last - first )
+    void hash_of_string_chunk_range( const unsigned char* chars, std::size_t first, std::size_t last, _ULARGELARGE_INTEGER__XX * values ) const
+    {
+        for ( std::size_t i=first; i<last; i++ )
+        {
+            hash_of_string_chunk_compact( curr_rd[0].random_coeff, *(ULARGE_INTEGER__XX*)(&(curr_rd[0].const_term)), ((const uint64_t*)(chars)) + ( i << PMPML_CHUNK_SIZE_LOG2_64 ), values[ i - first ] );
+        }
+    }
+
+public:
+    // Returns the same value as hash(). Level-0 chunks are independent, so they are
+    // hashed by up to threadCount threads, a batch at a time; the resulting values
+    // are then fed into the upper levels in order by the calling thread.
+    // Only inputs of at least PMPML_PARALLEL_MIN_CHUNKS_PER_THREAD_64 chunks per
+    // thread are split; shorter ones are hashed by hash() directly.
+    uint64_t hash_parallel( const unsigned char* chars, std::size_t cnt, unsigned int threadCount ) const
+    {
+        std::size_t chunkCnt = cnt >> PMPML_CHUNK_SIZE_BYTES_LOG2_64;
+        if ( threadCount > chunkCnt / PMPML_PARALLEL_MIN_CHUNKS_PER_THREAD_64 )
+            threadCount = (unsigned int)( chunkCnt / PMPML_PARALLEL_MIN_CHUNKS_PER_THREAD_64 );
+        if ( threadCount <= 1 )
+            return hash( chars, cnt );
+
+        _ULARGELARGE_INTEGER__XX allValues[ PMPML_LEVELS_64 * PMPML_CHUNK_SIZE_64 ];
+        std::size_t cnts[ PMPML_LEVELS_64 ];
+        std::size_t flag;
+        cnts[ 1 ] = 0;
+        flag = 0;
+
+        std::size_t batchSize = chunkCnt < PMPML_PARALLEL_BATCH_CHUNKS_64 ? chunkCnt : PMPML_PARALLEL_BATCH_CHUNKS_64;
+        std::vector<_ULARGELARGE_INTEGER__XX> chunkValues( batchSize );
+        std::vector<std::thread> workers;
+        workers.reserve( threadCount - 1 );
+        for ( std::size_t batchStart = 0; batchStart < chunkCnt; batchStart += batchSize )
+        {
+            std::size_t batchCnt = chunkCnt - batchStart < batchSize ? chunkCnt - batchStart : batchSize;
+            std::size_t perThread = ( batchCnt + threadCount - 1 ) / threadCount;
+            std::size_t serialFrom = batchCnt; // chunks from here on are left to this thread if a spawn fails
+            for ( std::size_t first = perThread; first < batchCnt; first += perThread )
+            {
+                std::size_t last = first + perThread < batchCnt ? first + perThread : batchCnt;
+                try
+                {
+                    workers.push_back( std::thread( &PMP_Multilinear_Hasher_64::hash_of_string_chunk_range, this,
+                                                    chars, batchStart + first, batchStart + last, chunkValues.data() + first ) );
+                }
+                catch ( const std::system_error& )
+                {
+                    // out of threads: the started workers are still joined below, the rest runs serially
+                    serialFrom = first;
+                    break;
+                }
+            }
+            hash_of_string_chunk_range( chars, batchStart, batchStart + perThread, chunkValues.data() );
+            if ( serialFrom < batchCnt )
+                hash_of_string_chunk_range( chars, batchStart + serialFrom, batchStart + batchCnt, chunkValues.data() + serialFrom );
+            for ( std::size_t t=0; t<workers.size(); t++ )
+                workers[ t ].join();
+            workers.clear();
+
+            for ( std::size_t i=0; i<batchCnt; i++ )
+            {
+                _ULARGELARGE_INTEGER__XX value = chunkValues[ i ];
+                procesNextValue( 1, value, allValues, cnts, flag );
+            }
+        }
+        return hash_of_tail_and_finalize_type2( chars, cnt, allValues, cnts, flag );
+    }
+
 
 public:
     PMP_Multilinear_Hasher_64()
     {
         curr_rd = rd_for_PMPML_64;
+        curr_rd_owned = false;
+    }
+    // uses a caller-provided coefficient table, e.g. PMPML_Seeded_Coefficients_64<Seed>::rd; it must outlive the hasher
+    explicit PMP_Multilinear_Hasher_64( const random_data_for_PMPML_64* rd )
+    {
+        curr_rd = rd;
+        curr_rd_owned = false;
     }
     ~PMP_Multilinear_Hasher_64()
     {
-        if ( curr_rd != NULL && curr_rd != rd_for_PMPML_64 )
+        if ( curr_rd_owned )
             delete [] curr_rd;
     }
 
@@ -1200,14 +1448,10 @@ public:
             temp_curr_rd[ i ].const_term = rv;
         }
 
-        if ( curr_rd == rd_for_PMPML_64 )
-            curr_rd = temp_curr_rd;
-        else
-        {
-            if ( curr_rd != NULL )
-                delete [] curr_rd;
-            curr_rd = temp_curr_rd;
-        }
+        if ( curr_rd_owned )
+            delete [] curr_rd;
+        curr_rd = temp_curr_rd;
+        curr_rd_owned = true;
     }
 };
 
@@ -149,8 +149,7 @@ __asm__( "mulq %4\n" \
 
 #define PMPML_CHUNK_LOOP_INTRO_L0_64_OUT_32 \
 	uint64_t ctr; \
-	ctr = 0; \
-	ULARGE_INTEGER__XX mul;
+	ctr = 0;
 
 #ifdef _MSC_VER
 
@@ -629,13 +628,11 @@ private:
 
         __m256i ctr0, ctr1;
         __m256i a, data, product, temp;
-        uint64_t temp_fin;
         int i;
 
         ctr0 = _mm256_setzero_si256 (); // Sets the 128-bit value to zero.
         ctr1 = _mm256_setzero_si256 ();
 
-        uint32_t *x1, *x2, *x3, *c1, *c2, *c3;
 
 #if (PMPML_CHUNK_SIZE >= 64)
         for ( i=0; i<PMPML_CHUNK_SIZE; i+=64 )
@@ -933,18 +930,15 @@ private:
 #endif
 #elif PMPML_USE_SSE_SIZE == 256
 
-            __m256i ctr0, ctr1, mask_low;
+            __m256i ctr0, ctr1;
             __m256i a, data, product, temp;
-            uint64_t temp_fin;
             int i;
 
             ctr0 = _mm256_setzero_si256 (); // Sets the 128-bit value to zero.
             ctr1 = _mm256_setzero_si256 ();
-            mask_low = _mm256_set_epi32 ( 0, -1, 0 , -1, 0, -1, 0 , -1 );
 
-            uint32_t *x1, *x2, *x3, *c1, *c2, *c3;
 
-            for ( i=0; i<(size&0xFFFFFFF8); i+=8 )
+            for ( i=0; i<(int)(size&0xFFFFFFF8); i+=8 )
             {
                 a = _mm256_load_si256 ((__m256i *)(coeff+i)); // Loads 256-bit value. Address p must be 32-byte aligned.
                 data = _mm256_loadu_si256 ((__m256i *)(x+i)); // Loads 256-bit value. Address p does not need be 32-byte aligned.
@@ -1141,18 +1135,15 @@ private:
 #endif
 #elif PMPML_USE_SSE_SIZE == 256
 
-            __m256i ctr0, ctr1, mask_low;
+            __m256i ctr0, ctr1;
             __m256i a, data, product, temp;
-            uint64_t temp_fin;
             int i;
 
             ctr0 = _mm256_setzero_si256 (); // Sets the 128-bit value to zero.
             ctr1 = _mm256_setzero_si256 ();
-            mask_low = _mm256_set_epi32 ( 0, -1, 0 , -1, 0, -1, 0 , -1 );
 
-            uint32_t *x1, *x2, *x3, *c1, *c2, *c3;
 
-            for ( i=0; i<(size&0xFFFFFFF8); i+=8 )
+            for ( i=0; i<(int)(size&0xFFFFFFF8); i+=8 )
             {
                 a = _mm256_load_si256 ((__m256i *)(coeff+i)); // Loads 256-bit value. Address p must be 32-byte aligned.
                 data = _mm256_loadu_si256 ((__m256i *)(x+i)); // Loads 256-bit value. Address p does not need be 32-byte aligned.
@@ -1331,9 +1322,9 @@ private:
         else
         {
             for ( i=0; i<count; i++ )
-                PMPML_CHUNK_LOOP_BODY_ULI_T1_64_OUT_32( 0 + i )
-                for ( ; i<PMPML_CHUNK_SIZE; i++ )
-                    c_ctr.QuadPart += coeff[ i ];
+                { PMPML_CHUNK_LOOP_BODY_ULI_T1_64_OUT_32( 0 + i ) }
+            for ( ; i<PMPML_CHUNK_SIZE; i++ )
+                c_ctr.QuadPart += coeff[ i ];
         }
 
         MULADD_MUL64x64to128ADDto128__( constTerm.QuadPart, ctr, c_ctr.QuadPart, prevConstTerm.QuadPart )
@@ -1555,7 +1546,6 @@ public:
 
     NOINLINE uint32_t _hash_noRecursionNoInline_forLessThanChunk(const unsigned char* chars, unsigned int cnt) const
     {
-        unsigned int i;
         ULARGE_INTEGER__XX tmp_hash;
         tmp_hash.QuadPart = hash_of_beginning_of_string_chunk_type2( curr_rd[0].random_coeff, *(ULARGE_INTEGER__XX*)(&(curr_rd[0].const_term)), chars, cnt );
         if ( tmp_hash.HighPart == 0 ) //LIKELY
@@ -159,7 +159,11 @@ uint64_t fmix64_short ( uint64_t k )
 #define PMPML_USE_SSE // makes sense for x86 processors only with SSE 
 
 #ifdef PMPML_USE_SSE
+#ifdef __AVX2__
+#define PMPML_USE_SSE_SIZE 256 // 128 or 256
+#else
 #define PMPML_USE_SSE_SIZE 128 // 128 or 256
+#endif
 
 #if PMPML_USE_SSE_SIZE == 128
 #include <emmintrin.h>
@@ -219,6 +223,9 @@ extern const random_data_for_MPSHF rd_for_MPSHF[ PMPML_LEVELS ];
 
 #if !defined __arm__
 //#define PMPML_USE_SSE_64 // makes sense for x86 processors only supporting AVX-2 instruction set (256 bit)
+#if defined __AVX512F__ && !defined PMPML_NO_AVX512_64
+#define PMPML_USE_AVX512_64 // 8 words per step in 512-bit registers; define PMPML_NO_AVX512_64 to disable
+#endif
 #endif
 
 // constants
@@ -238,6 +245,10 @@ extern const random_data_for_MPSHF rd_for_MPSHF[ PMPML_LEVELS ];
 #define PMPML_CHUNK_SIZE_BYTES_LOG2_64 ( PMPML_CHUNK_SIZE_LOG2_64 + PMPML_WORD_SIZE_BYTES_LOG2_64 ) // derived
 #define PMPML_LEVELS_64 8
 
+// parallel hashing: level-0 chunks hashed concurrently per batch, and the least number of chunks worth a thread
+#define PMPML_PARALLEL_BATCH_CHUNKS_64 ( 1 << 15 )
+#define PMPML_PARALLEL_MIN_CHUNKS_PER_THREAD_64 256
+
 // container for coefficients
 typedef struct _random_data_for_PMPML_64
 {
@@ -0,0 +1,107 @@
+/*
+   HalfSipHash, following the SipHash reference C implementation
+
+   Copyright (c) 2012-2016 Jean-Philippe Aumasson <jeanphilippe.aumasson@gmail.com>
+   Copyright (c) 2012-2014 Daniel J. Bernstein <djb@cr.yp.to>
+
+   To the extent possible under law, the author(s) have dedicated all copyright
+   and related and neighboring rights to this software to the public domain
+   worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with
+   this software. If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+#include <stdint.h>
+#include <string.h>
+
+/* default: HalfSipHash-2-4 */
+#define cROUNDS 2
+#define dROUNDS 4
+
+#define ROTL(x,b) (uint32_t)( ((x) << (b)) | ( (x) >> (32 - (b))) )
+
+#define U32TO8_LE(p, v)                                         \
+  (p)[0] = (uint8_t)((v)      ); (p)[1] = (uint8_t)((v) >>  8); \
+  (p)[2] = (uint8_t)((v) >> 16); (p)[3] = (uint8_t)((v) >> 24);
+
+#define U8TO32_LE(p)            \
+  (((uint32_t)((p)[0])      ) | \
+   ((uint32_t)((p)[1]) <<  8) | \
+   ((uint32_t)((p)[2]) << 16) | \
+   ((uint32_t)((p)[3]) << 24))
+
+#define SIPROUND                                        \
+  do {                                                  \
+    v0 += v1; v1=ROTL(v1, 5); v1 ^= v0; v0=ROTL(v0,16); \
+    v2 += v3; v3=ROTL(v3, 8); v3 ^= v2;                 \
+    v0 += v3; v3=ROTL(v3, 7); v3 ^= v0;                 \
+    v2 += v1; v1=ROTL(v1,13); v1 ^= v2; v2=ROTL(v2,16); \
+  } while(0)
+
+int  halfsiphash( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k, int outlen )
+{
+  uint32_t v0 = 0;
+  uint32_t v1 = 0;
+  uint32_t v2 = 0x6c796765;
+  uint32_t v3 = 0x74656462;
+  uint32_t k0 = U8TO32_LE( k );
+  uint32_t k1 = U8TO32_LE( k + 4 );
+  uint32_t m;
+  int i;
+  const uint8_t *end = in + inlen - ( inlen % sizeof( uint32_t ) );
+  const int left = inlen & 3;
+  uint32_t b = ( ( uint32_t )inlen ) << 24;
+  v3 ^= k1;
+  v2 ^= k0;
+  v1 ^= k1;
+  v0 ^= k0;
+
+  if( outlen == 8 )
+    v1 ^= 0xee;
+
+  for ( ; in != end; in += 4 )
+  {
+    m = U8TO32_LE( in );
+    v3 ^= m;
+
+    for( i=0; i<cROUNDS; ++i ) SIPROUND;
+
+    v0 ^= m;
+  }
+
+  switch( left )
+  {
+  case 3: b |= ( ( uint32_t )in[ 2] )  << 16; /* fall through */
+  case 2: b |= ( ( uint32_t )in[ 1] )  <<  8; /* fall through */
+  case 1: b |= ( ( uint32_t )in[ 0] ); break;
+  case 0: break;
+  }
+
+  v3 ^= b;
+
+  for( i=0; i<cROUNDS; ++i ) SIPROUND;
+
+  v0 ^= b;
+
+  if( outlen == 8 )
+    v2 ^= 0xee;
+  else
+    v2 ^= 0xff;
+
+  for( i=0; i<dROUNDS; ++i ) SIPROUND;
+
+  b = v1 ^ v3;
+  U32TO8_LE( out, b );
+
+  if( outlen == 4 )
+    return 0;
+
+  v1 ^= 0xdd;
+
+  for( i=0; i<dROUNDS; ++i ) SIPROUND;
+
+  b = v1 ^ v3;
+  U32TO8_LE( out + 4, b );
+
+  return 0;
+}
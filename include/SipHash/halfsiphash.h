@@ -0,0 +1,9 @@
+#ifndef __HALFSIPHASH
+#define __HALFSIPHASH
+
+/* HalfSipHash-2-4: SipHash on 32-bit words with a 64-bit key k (8 bytes),
+   writing outlen (4 or 8) bytes to out. */
+int  halfsiphash( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k, int outlen );
+
+
+#endif
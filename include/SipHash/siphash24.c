@@ -63,7 +63,10 @@
 #define TRACE
 #endif
 
-int  siphash( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k )
+/* SipHash-c-d; inlined into each variant so the round loops stay unrolled */
+static inline __attribute__((always_inline))
+int  siphash_cd( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k,
+                 const int crounds, const int drounds )
 {
   /* "somepseudorandomlygeneratedbytes" */
   uint64_t v0 = 0x736f6d6570736575ULL;
@@ -93,7 +96,7 @@ int  siphash( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k
     v3 ^= m;
      
     TRACE;
-    for( i=0; i<cROUNDS; ++i ) SIPROUND;
+    for( i=0; i<crounds; ++i ) SIPROUND;
 
     v0 ^= m;
   }
@@ -114,7 +117,7 @@ int  siphash( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k
   v3 ^= b;
 
   TRACE;
-  for( i=0; i<cROUNDS; ++i ) SIPROUND;
+  for( i=0; i<crounds; ++i ) SIPROUND;
 
   v0 ^= b;
 
@@ -125,7 +128,7 @@ int  siphash( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k
 #endif
 
   TRACE;
-  for( i=0; i<dROUNDS; ++i ) SIPROUND;
+  for( i=0; i<drounds; ++i ) SIPROUND;
 
   b = v0 ^ v1 ^ v2  ^ v3;
   U64TO8_LE( out, b );
@@ -134,11 +137,191 @@ int  siphash( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k
   v1 ^= 0xdd;
 
   TRACE;
-  for( i=0; i<dROUNDS; ++i ) SIPROUND;
+  for( i=0; i<drounds; ++i ) SIPROUND;
 
   b = v0 ^ v1 ^ v2  ^ v3;
   U64TO8_LE( out+8, b );
 #endif
 
   return 0;
-}
\ No newline at end of file
+}
+
+int  siphash( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k )
+{
+  return siphash_cd( out, in, inlen, k, cROUNDS, dROUNDS );
+}
+
+/* SipHash-1-3: the faster variant proposed by the SipHash authors for hash tables */
+int  siphash13( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k )
+{
+  return siphash_cd( out, in, inlen, k, 1, 3 );
+}
+
+/*
+   Batched SipHash-2-4: count independent messages under one key, out[i] being
+   the value siphash() stores (little endian) for in[i], inlen[i].
+   With AVX-512 (AVX2) 8 (4) messages run in the 64-bit lanes of one vector:
+   lane j compresses its inlen[j]/8 words and then its final length word, and
+   keeps its state once done while longer lanes go on. Lengths within a batch
+   should be similar, the longest one sets the pace.
+ */
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+static uint64_t siphash_last_word( const uint8_t *in, uint64_t inlen )
+{
+  uint64_t b = ( ( uint64_t )inlen ) << 56;
+  const uint8_t *tail = in + inlen - ( inlen & 7 );
+  switch( inlen & 7 )
+  {
+  case 7: b |= ( ( uint64_t )tail[ 6] )  << 48; /* fall through */
+  case 6: b |= ( ( uint64_t )tail[ 5] )  << 40; /* fall through */
+  case 5: b |= ( ( uint64_t )tail[ 4] )  << 32; /* fall through */
+  case 4: b |= ( ( uint64_t )tail[ 3] )  << 24; /* fall through */
+  case 3: b |= ( ( uint64_t )tail[ 2] )  << 16; /* fall through */
+  case 2: b |= ( ( uint64_t )tail[ 1] )  <<  8; /* fall through */
+  case 1: b |= ( ( uint64_t )tail[ 0] ); break;
+  case 0: break;
+  }
+  return b;
+}
+
+#if defined(__AVX512F__)
+
+#define SIPHASH_LANES 8
+
+#define SIPROUND_X8                                                              \
+  do {                                                                           \
+    v0 = _mm512_add_epi64(v0, v1); v1 = _mm512_rol_epi64(v1, 13);                \
+    v1 = _mm512_xor_si512(v1, v0); v0 = _mm512_rol_epi64(v0, 32);                \
+    v2 = _mm512_add_epi64(v2, v3); v3 = _mm512_rol_epi64(v3, 16);                \
+    v3 = _mm512_xor_si512(v3, v2);                                               \
+    v0 = _mm512_add_epi64(v0, v3); v3 = _mm512_rol_epi64(v3, 21);                \
+    v3 = _mm512_xor_si512(v3, v0);                                               \
+    v2 = _mm512_add_epi64(v2, v1); v1 = _mm512_rol_epi64(v1, 17);                \
+    v1 = _mm512_xor_si512(v1, v2); v2 = _mm512_rol_epi64(v2, 32);                \
+  } while(0)
+
+static void siphash_lanes( uint64_t *out, const uint8_t *const *in, const uint64_t *inlen,
+                           uint64_t k0, uint64_t k1 )
+{
+  uint64_t last[ SIPHASH_LANES ], words[ SIPHASH_LANES ], steps = 0;
+  int j, i;
+  for( j = 0; j < SIPHASH_LANES; ++j )
+  {
+    last[ j ] = siphash_last_word( in[ j ], inlen[ j ] );
+    words[ j ] = inlen[ j ] / 8;
+    if( words[ j ] + 1 > steps ) steps = words[ j ] + 1;
+  }
+  const __m512i nwords = _mm512_loadu_si512( words );
+  const __m512i b = _mm512_loadu_si512( last );
+  __m512i addr = _mm512_loadu_si512( ( const void * )in );
+  __m512i v0 = _mm512_set1_epi64( 0x736f6d6570736575ULL ^ k0 );
+  __m512i v1 = _mm512_set1_epi64( 0x646f72616e646f6dULL ^ k1 );
+  __m512i v2 = _mm512_set1_epi64( 0x6c7967656e657261ULL ^ k0 );
+  __m512i v3 = _mm512_set1_epi64( 0x7465646279746573ULL ^ k1 );
+  uint64_t t;
+  for( t = 0; t < steps; ++t )
+  {
+    const __m512i step = _mm512_set1_epi64( t );
+    const __mmask8 full = _mm512_cmplt_epu64_mask( step, nwords );
+    const __mmask8 active = _mm512_cmple_epu64_mask( step, nwords );
+    const __m512i m = _mm512_mask_i64gather_epi64( b, full, addr, NULL, 1 );
+    const __m512i s0 = v0, s1 = v1, s2 = v2, s3 = v3;
+    v3 = _mm512_xor_si512( v3, m );
+    for( i=0; i<cROUNDS; ++i ) SIPROUND_X8;
+    v0 = _mm512_xor_si512( v0, m );
+    v0 = _mm512_mask_blend_epi64( active, s0, v0 );
+    v1 = _mm512_mask_blend_epi64( active, s1, v1 );
+    v2 = _mm512_mask_blend_epi64( active, s2, v2 );
+    v3 = _mm512_mask_blend_epi64( active, s3, v3 );
+    addr = _mm512_add_epi64( addr, _mm512_set1_epi64( 8 ) );
+  }
+  v2 = _mm512_xor_si512( v2, _mm512_set1_epi64( 0xff ) );
+  for( i=0; i<dROUNDS; ++i ) SIPROUND_X8;
+  _mm512_storeu_si512( out, _mm512_xor_si512( _mm512_xor_si512( v0, v1 ), _mm512_xor_si512( v2, v3 ) ) );
+}
+
+#elif defined(__AVX2__)
+
+#define SIPHASH_LANES 4
+
+#define ROTL_X4(x,b) _mm256_or_si256( _mm256_slli_epi64( (x), (b) ), _mm256_srli_epi64( (x), 64 - (b) ) )
+#define ROTL32_X4(x) _mm256_shuffle_epi32( (x), 0xb1 )
+#define ROTL16_X4(x) _mm256_shuffle_epi8( (x), _mm256_setr_epi8(                   \
+    6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11, 12, 13,                         \
+    6, 7, 0, 1, 2, 3, 4, 5, 14, 15, 8, 9, 10, 11, 12, 13 ) )
+
+#define SIPROUND_X4                                                              \
+  do {                                                                           \
+    v0 = _mm256_add_epi64(v0, v1); v1 = ROTL_X4(v1, 13);                         \
+    v1 = _mm256_xor_si256(v1, v0); v0 = ROTL32_X4(v0);                           \
+    v2 = _mm256_add_epi64(v2, v3); v3 = ROTL16_X4(v3);                             \
+    v3 = _mm256_xor_si256(v3, v2);                                               \
+    v0 = _mm256_add_epi64(v0, v3); v3 = ROTL_X4(v3, 21);                         \
+    v3 = _mm256_xor_si256(v3, v0);                                               \
+    v2 = _mm256_add_epi64(v2, v1); v1 = ROTL_X4(v1, 17);                         \
+    v1 = _mm256_xor_si256(v1, v2); v2 = ROTL32_X4(v2);                           \
+  } while(0)
+
+static void siphash_lanes( uint64_t *out, const uint8_t *const *in, const uint64_t *inlen,
+                           uint64_t k0, uint64_t k1 )
+{
+  uint64_t last[ SIPHASH_LANES ], words[ SIPHASH_LANES ], steps = 0;
+  int j, i;
+  for( j = 0; j < SIPHASH_LANES; ++j )
+  {
+    last[ j ] = siphash_last_word( in[ j ], inlen[ j ] );
+    words[ j ] = inlen[ j ] / 8;
+    if( words[ j ] + 1 > steps ) steps = words[ j ] + 1;
+  }
+  /* lengths are far below 2^63, so signed compares are fine */
+  const __m256i nwords = _mm256_loadu_si256( ( const __m256i * )words );
+  const __m256i b = _mm256_loadu_si256( ( const __m256i * )last );
+  __m256i addr = _mm256_loadu_si256( ( const __m256i * )in );
+  __m256i v0 = _mm256_set1_epi64x( 0x736f6d6570736575ULL ^ k0 );
+  __m256i v1 = _mm256_set1_epi64x( 0x646f72616e646f6dULL ^ k1 );
+  __m256i v2 = _mm256_set1_epi64x( 0x6c7967656e657261ULL ^ k0 );
+  __m256i v3 = _mm256_set1_epi64x( 0x7465646279746573ULL ^ k1 );
+  uint64_t t;
+  for( t = 0; t < steps; ++t )
+  {
+    const __m256i step = _mm256_set1_epi64x( t );
+    const __m256i full = _mm256_cmpgt_epi64( nwords, step );
+    const __m256i active = _mm256_or_si256( full, _mm256_cmpeq_epi64( nwords, step ) );
+    const __m256i m = _mm256_mask_i64gather_epi64( b, ( const long long * )0, addr, full, 1 );
+    const __m256i s0 = v0, s1 = v1, s2 = v2, s3 = v3;
+    v3 = _mm256_xor_si256( v3, m );
+    for( i=0; i<cROUNDS; ++i ) SIPROUND_X4;
+    v0 = _mm256_xor_si256( v0, m );
+    v0 = _mm256_blendv_epi8( s0, v0, active );
+    v1 = _mm256_blendv_epi8( s1, v1, active );
+    v2 = _mm256_blendv_epi8( s2, v2, active );
+    v3 = _mm256_blendv_epi8( s3, v3, active );
+    addr = _mm256_add_epi64( addr, _mm256_set1_epi64x( 8 ) );
+  }
+  v2 = _mm256_xor_si256( v2, _mm256_set1_epi64x( 0xff ) );
+  for( i=0; i<dROUNDS; ++i ) SIPROUND_X4;
+  _mm256_storeu_si256( ( __m256i * )out, _mm256_xor_si256( _mm256_xor_si256( v0, v1 ), _mm256_xor_si256( v2, v3 ) ) );
+}
+
+#endif
+
+void siphash_batch( uint64_t *out, const uint8_t *const *in, const uint64_t *inlen,
+                    size_t count, const uint8_t *k )
+{
+  size_t n = 0;
+#ifdef SIPHASH_LANES
+  const uint64_t k0 = U8TO64_LE( k );
+  const uint64_t k1 = U8TO64_LE( k + 8 );
+  for( ; n + SIPHASH_LANES <= count; n += SIPHASH_LANES )
+    siphash_lanes( out + n, in + n, inlen + n, k0, k1 );
+#endif
+  for( ; n < count; ++n )
+  {
+    uint8_t digest[ 8 ];
+    siphash( digest, in[ n ], inlen[ n ], k );
+    out[ n ] = U8TO64_LE( digest );
+  }
+}
@@ -3,5 +3,14 @@
 
 int  siphash( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k );
 
+/* SipHash-1-3, same interface as siphash (SipHash-2-4) */
+int  siphash13( uint8_t *out, const uint8_t *in, uint64_t inlen, const uint8_t *k );
+
+/* SipHash-2-4 of count messages under the same key k; out[i] is siphash()'s
+   output for in[i], inlen[i] read as a little-endian 64-bit value. Messages
+   are hashed 8 (AVX-512) or 4 (AVX2) at a time in SIMD lanes. */
+void siphash_batch( uint64_t *out, const uint8_t *const *in, const uint64_t *inlen,
+                    size_t count, const uint8_t *k );
+
 
 #endif
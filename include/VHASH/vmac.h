@@ -18,6 +18,9 @@
 #define VMAC_PREFER_BIG_ENDIAN  0  /* Prefer non-x86 */
 
 #define VMAC_USE_OPENSSL  0 /* Set to non-zero to use OpenSSL's AES        */
+#ifndef VMAC_USE_AESNI      /* Non-zero: AES-NI instructions, 128-bit keys  */
+#define VMAC_USE_AESNI (__AES__ && (VMAC_KEY_LEN == 128) && !VMAC_USE_OPENSSL)
+#endif
 #define VMAC_CACHE_NONCES 1 /* Set to non-zero to cause caching            */
                             /* of consecutive nonces on 64-bit tags        */
 
@@ -42,6 +45,8 @@
  * Microsoft C environment.
  * ----------------------------------------------------------------------- */
 #define VMAC_USE_STDINT 1  /* Set to zero if system has no stdint.h        */
+
+#include <stddef.h>
  
 #if VMAC_USE_STDINT && !_MSC_VER /* Try stdint.h if non-Microsoft          */
 #ifdef  __cplusplus
@@ -77,6 +82,17 @@ typedef AES_KEY aes_int_key;
 #define aes_key_setup(key,int_key)                      \
 	    	AES_set_encrypt_key((key),VMAC_KEY_LEN,(int_key))
 
+#elif VMAC_USE_AESNI
+
+#include <wmmintrin.h>
+typedef __m128i aes_int_key[VMAC_KEY_LEN/32+7]; /* the 11 round keys     */
+
+#define aes_encryption(in,out,int_key)                  \
+	    	vmac_aesni_encrypt((unsigned char *)(in),       \
+	    	                   (unsigned char *)(out), *(int_key))
+#define aes_key_setup(user_key,int_key)                 \
+	    	vmac_aesni_key_setup((unsigned char *)(user_key), *(int_key))
+
 #else
 
 #include "rijndael-alg-fst.h"
@@ -167,6 +183,41 @@ void vmac_set_key(unsigned char user_key[], vmac_ctx_t *ctx);
 
 void vhash_abort(vmac_ctx_t *ctx);
 
+/* vhash of a message of any length. vhash itself reads the last partial
+ * 16-byte word whole, so it needs zero padding after the message; here
+ * such a tail is copied to a padded buffer (up to VMAC_NHBYTES bytes),
+ * lengths divisible by 16 are hashed in place.                           */
+uint64_t vhash_bytes(const unsigned char m[],
+          size_t mbytes,
+          uint64_t *tagl,
+          vmac_ctx_t *ctx);
+
+/* Streaming vhash: any number of updates with any byte counts, then
+ * vhash_stream_final gives vhash of the concatenation. The stream works
+ * on its own copy of a prepared context, so one prepared context may seed
+ * many streams. Whole blocks are hashed straight from the caller's memory
+ * whenever nothing is buffered.                                          */
+typedef struct {
+	vmac_ctx_t ctx;
+	unsigned char buffer[VMAC_NHBYTES];
+	unsigned int buffered;
+} vhash_stream_t;
+
+void vhash_stream_init(vhash_stream_t *s, const vmac_ctx_t *prepared);
+
+void vhash_stream_update(vhash_stream_t *s,
+          const unsigned char m[],
+          size_t mbytes);
+
+uint64_t vhash_stream_final(vhash_stream_t *s, uint64_t *tagl);
+
+#if VMAC_USE_AESNI && !VMAC_USE_OPENSSL
+void vmac_aesni_key_setup(const unsigned char user_key[16], __m128i round_keys[11]);
+
+void vmac_aesni_encrypt(const unsigned char in[16], unsigned char out[16],
+          const __m128i round_keys[11]);
+#endif
+
 /* --------------------------------------------------------------------- */
 
 #ifdef  __cplusplus
@@ -0,0 +1,22 @@
+#ifndef AVX512DIAGNOSTICS_H_
+#define AVX512DIAGNOSTICS_H_
+
+// GCC 12 fills the pass-through operand of the unmasked AVX-512 intrinsics with
+// _mm512_undefined_*(), a deliberately uninitialized local, and -Wall then flags it
+// at every inlined use in C++. The report points into the compiler's own headers, so
+// it cannot be silenced intrinsic by intrinsic: AVX512_KERNELS_BEGIN turns off
+// -Wmaybe-uninitialized and -Wuninitialized altogether until AVX512_KERNELS_END.
+// Keep each bracketed region to the AVX-512 kernels and the functions they are
+// inlined into; a genuinely uninitialized variable there goes unreported too.
+#if defined(__GNUC__) && !defined(__clang__)
+#define AVX512_KERNELS_BEGIN                                          \
+    _Pragma("GCC diagnostic push")                                    \
+    _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")       \
+    _Pragma("GCC diagnostic ignored \"-Wuninitialized\"")
+#define AVX512_KERNELS_END _Pragma("GCC diagnostic pop")
+#else
+#define AVX512_KERNELS_BEGIN
+#define AVX512_KERNELS_END
+#endif
+
+#endif /* AVX512DIAGNOSTICS_H_ */
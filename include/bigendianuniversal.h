@@ -17,6 +17,8 @@
 // where L is the maximum length of a string.
 
 #include <string.h>
+#include <immintrin.h>
+#include "avx512diagnostics.h"
 
 // Unsigned 128-bit integers
 typedef struct U128 {
@@ -62,6 +64,177 @@ uint64_t hornerHash(const void * randomSource,
   return accum.hi;
 }
 
+// The same Horner step as multHi128(h, {accum, word}).hi, written
+// with mulx (when available) so that the compiler can schedule
+// several independent steps together: the mulq in hi64mul pins its
+// operands to rax and rdx.
+static inline uint64_t hornerStep(const uint64_t hlo, const uint64_t hhi,
+                                  const uint64_t accum, const uint64_t word) {
+#ifdef __BMI2__
+  unsigned long long hi;
+  _mulx_u64(hlo, word, &hi);
+#else
+  const uint64_t hi = hi64mul(hlo, word);
+#endif
+  return hlo * accum + hhi * word + hi;
+}
+
+#ifdef __AVX2__
+// hornerStep on 4 lanes with 32x32->64 multiplies. hlo32 and hhi32
+// are the high halves of hlo and hhi, shifted down.
+static inline __m256i hornerStep256(const __m256i hlo, const __m256i hlo32,
+                                    const __m256i hhi, const __m256i hhi32,
+                                    const __m256i accum, const __m256i word) {
+  const __m256i mask = _mm256_set1_epi64x(0xffffffff);
+  const __m256i accum32 = _mm256_srli_epi64(accum, 32);
+  const __m256i word32 = _mm256_srli_epi64(word, 32);
+  // the low 64 bits of hlo * accum and hhi * word
+  const __m256i cross = _mm256_add_epi64(
+      _mm256_add_epi64(_mm256_mul_epu32(accum, hlo32),
+                       _mm256_mul_epu32(accum32, hlo)),
+      _mm256_add_epi64(_mm256_mul_epu32(word, hhi32),
+                       _mm256_mul_epu32(word32, hhi)));
+  const __m256i low = _mm256_add_epi64(
+      _mm256_add_epi64(_mm256_mul_epu32(accum, hlo),
+                       _mm256_mul_epu32(word, hhi)),
+      _mm256_slli_epi64(cross, 32));
+  // the high 64 bits of hlo * word
+  const __m256i ll = _mm256_mul_epu32(hlo, word);
+  const __m256i lh = _mm256_mul_epu32(hlo, word32);
+  const __m256i hl = _mm256_mul_epu32(hlo32, word);
+  const __m256i hh = _mm256_mul_epu32(hlo32, word32);
+  const __m256i middle = _mm256_add_epi64(
+      _mm256_add_epi64(_mm256_srli_epi64(ll, 32), _mm256_and_si256(lh, mask)),
+      _mm256_and_si256(hl, mask));
+  const __m256i high = _mm256_add_epi64(
+      _mm256_add_epi64(hh, _mm256_srli_epi64(middle, 32)),
+      _mm256_add_epi64(_mm256_srli_epi64(lh, 32), _mm256_srli_epi64(hl, 32)));
+  return _mm256_add_epi64(low, high);
+}
+#endif
+
+AVX512_KERNELS_BEGIN
+
+#if defined(__AVX512F__)
+// hornerStep256 on 8 lanes
+static inline __m512i hornerStep512(const __m512i hlo, const __m512i hlo32,
+                                    const __m512i hhi, const __m512i hhi32,
+                                    const __m512i accum, const __m512i word) {
+  const __m512i mask = _mm512_set1_epi64(0xffffffff);
+  const __m512i accum32 = _mm512_srli_epi64(accum, 32);
+  const __m512i word32 = _mm512_srli_epi64(word, 32);
+  const __m512i cross = _mm512_add_epi64(
+      _mm512_add_epi64(_mm512_mul_epu32(accum, hlo32),
+                       _mm512_mul_epu32(accum32, hlo)),
+      _mm512_add_epi64(_mm512_mul_epu32(word, hhi32),
+                       _mm512_mul_epu32(word32, hhi)));
+  const __m512i low = _mm512_add_epi64(
+      _mm512_add_epi64(_mm512_mul_epu32(accum, hlo),
+                       _mm512_mul_epu32(word, hhi)),
+      _mm512_slli_epi64(cross, 32));
+  const __m512i ll = _mm512_mul_epu32(hlo, word);
+  const __m512i lh = _mm512_mul_epu32(hlo, word32);
+  const __m512i hl = _mm512_mul_epu32(hlo32, word);
+  const __m512i hh = _mm512_mul_epu32(hlo32, word32);
+  const __m512i middle = _mm512_add_epi64(
+      _mm512_add_epi64(_mm512_srli_epi64(ll, 32), _mm512_and_si512(lh, mask)),
+      _mm512_and_si512(hl, mask));
+  const __m512i high = _mm512_add_epi64(
+      _mm512_add_epi64(hh, _mm512_srli_epi64(middle, 32)),
+      _mm512_add_epi64(_mm512_srli_epi64(lh, 32), _mm512_srli_epi64(hl, 32)));
+  return _mm512_add_epi64(low, high);
+}
+#endif
+
+// hornerHash keeps one 128-bit multiplication in flight at a time.
+// hornerHashLanes##MANY deals the words out to MANY interleaved
+// lanes (word i goes to lane i % MANY), runs the hornerHash step on
+// each lane independently, and then combines the lanes with MANY - 1
+// more steps: lane 0 absorbs lane 1, then lane 2, and so on. Lane 0
+// starts from the length, the others from zero. Every word and every
+// lane result goes through one step with the same key as hornerHash,
+// so the family is (L + MANY - 1) * 2^{1-d}-almost big-endian
+// universal, with L the length. Multiplier powers, as in polynomial
+// hashing over a field, do not apply: the steps drop their low and
+// high words, so two steps are not one multiplication by h^2.
+// With 8 lanes the steps run on AVX-512 (one zmm register) or AVX2
+// (two ymm registers) with 32x32->64 multiplies, otherwise on mulx
+// chains; the result does not depend on which. The MANY - 1 combining
+// steps are serial, so for strings of a few words hornerHash remains
+// faster.
+#define DECLARE_LANED_HORNER(MANY)                                            \
+  uint64_t hornerHashLanes##MANY(const void *randomSource, const uint64_t *x, \
+                                 const size_t length) {                       \
+    uint64_t h[2];                                                            \
+    memcpy(h, randomSource, sizeof(h));                                       \
+    /* as in hornerHash: h.lo, the second key word, must be odd */            \
+    const uint64_t hhi = h[0], hlo = h[1] | 1;                                \
+    uint64_t accums[MANY] __attribute__((aligned(64)));                      \
+    accums[0] = length;                                                       \
+    for (size_t j = 1; j < MANY; ++j) {                                       \
+      accums[j] = 0;                                                          \
+    }                                                                         \
+    size_t i = 0;                                                             \
+    HORNER_LANES_LOOP##MANY                                                   \
+    for (; i + MANY <= length; i += MANY) {                                   \
+      for (size_t j = 0; j < MANY; ++j) {                                     \
+        accums[j] = hornerStep(hlo, hhi, accums[j], x[i + j]);                \
+      }                                                                       \
+    }                                                                         \
+    for (size_t j = 0; i + j < length; ++j) {                                 \
+      accums[j] = hornerStep(hlo, hhi, accums[j], x[i + j]);                  \
+    }                                                                         \
+    for (size_t j = 1; j < MANY; ++j) {                                       \
+      accums[0] = hornerStep(hlo, hhi, accums[0], accums[j]);                 \
+    }                                                                         \
+    return accums[0];                                                         \
+  }
+
+// 4 lanes fit one ymm register, but there the 32x32 multiplies are no
+// faster than 4 chains of mulx
+#define HORNER_LANES_LOOP4
+
+#if defined(__AVX512F__)
+#define HORNER_LANES_LOOP8                                                    \
+  if (length >= 32) { /* moving the lanes in and out costs more than 3 steps */ \
+    const __m512i vhlo = _mm512_set1_epi64((long long)hlo);                   \
+    const __m512i vhhi = _mm512_set1_epi64((long long)hhi);                   \
+    const __m512i vhlo32 = _mm512_srli_epi64(vhlo, 32);                       \
+    const __m512i vhhi32 = _mm512_srli_epi64(vhhi, 32);                       \
+    __m512i a = _mm512_load_si512((const void *)accums);                      \
+    for (; i + 8 <= length; i += 8) {                                         \
+      a = hornerStep512(vhlo, vhlo32, vhhi, vhhi32, a,                        \
+                        _mm512_loadu_si512((const void *)(x + i)));           \
+    }                                                                         \
+    _mm512_store_si512((void *)accums, a);                                    \
+  }
+#elif defined(__AVX2__)
+#define HORNER_LANES_LOOP8                                                    \
+  if (length >= 32) { /* moving the lanes in and out costs more than 3 steps */ \
+    const __m256i vhlo = _mm256_set1_epi64x((long long)hlo);                  \
+    const __m256i vhhi = _mm256_set1_epi64x((long long)hhi);                  \
+    const __m256i vhlo32 = _mm256_srli_epi64(vhlo, 32);                       \
+    const __m256i vhhi32 = _mm256_srli_epi64(vhhi, 32);                       \
+    __m256i a0 = _mm256_load_si256((const __m256i *)accums);                  \
+    __m256i a1 = _mm256_load_si256((const __m256i *)(accums + 4));            \
+    for (; i + 8 <= length; i += 8) {                                         \
+      a0 = hornerStep256(vhlo, vhlo32, vhhi, vhhi32, a0,                      \
+                         _mm256_loadu_si256((const __m256i *)(x + i)));       \
+      a1 = hornerStep256(vhlo, vhlo32, vhhi, vhhi32, a1,                      \
+                         _mm256_loadu_si256((const __m256i *)(x + i + 4)));   \
+    }                                                                         \
+    _mm256_store_si256((__m256i *)accums, a0);                                \
+    _mm256_store_si256((__m256i *)(accums + 4), a1);                          \
+  }
+#else
+#define HORNER_LANES_LOOP8
+#endif
+
+DECLARE_LANED_HORNER(4)
+DECLARE_LANED_HORNER(8)
+
+AVX512_KERNELS_END
+
 // Hashes two 64-bit words (newer and accum) down to one,
 // universally. h0 and h1 must be chosen uniformly at random.
 //
@@ -79,44 +252,6 @@ static inline void univHash(const uint64_t h0, const uint64_t h1,
   *accum = newer + *accum * h1 + hi64mul(*accum, h0);
 }
 
-// Horner's method can only dispatch one 128-bit multiplication at a
-// time, since each loop iteration depends on the one before
-// it. unrolledHorner changes the order in which the words are hashed
-// and can hash multiple words simultaneously, if the processor
-// supports it.
-#define DECLARE_UNROLLED_HORNER(MANY)                                        \
-  uint64_t unrolledHorner##MANY(const void *randomSource, const uint64_t *x, \
-                                const size_t length) {                     \
-    uint64_t accums[MANY];                                                   \
-    accums[0] = length;                                                      \
-    accums[1] = x[1];                                                        \
-    for (size_t i = 2; i < MANY; ++i) {                                      \
-      accums[i] = (i < length) ? x[i] : 0;                                   \
-    }                                                                        \
-    size_t i = (length < MANY) ? length : MANY;                              \
-    const uint64_t *r64 = (const uint64_t *)randomSource;                    \
-    for (; i + MANY <= length; i += MANY) {                                  \
-      for (size_t j = 0; j < MANY; ++j) {                                    \
-        univHash(r64[0], r64[1], x[i + j], &accums[j]);                      \
-      }                                                                      \
-    }                                                                        \
-    for (size_t j = 0; i+j < length; j += 1) {                               \
-      univHash(r64[0], r64[1], x[i+j], &accums[j]);                          \
-    }                                                                        \
-    for (size_t j = 1; j < MANY; ++j) {                                      \
-      univHash(r64[0], r64[1], accums[j], &accums[0]);                       \
-    }                                                                        \
-    return accums[0] * (r64[2] | ((uint64_t)1));                             \
-  }
-
-DECLARE_UNROLLED_HORNER(3)
-DECLARE_UNROLLED_HORNER(4)
-DECLARE_UNROLLED_HORNER(5)
-DECLARE_UNROLLED_HORNER(6)
-DECLARE_UNROLLED_HORNER(7)
-DECLARE_UNROLLED_HORNER(8)
-DECLARE_UNROLLED_HORNER(9)
-
 // One other way to calculate a 64-bit hash value is to calculate two
 // 32-bit hash values. In order to make this almost big-endian
 // universal, we have to rehash these two 32-bit values with an
@@ -205,224 +340,427 @@ static inline void clCombine(const __m128i r128, __m128i *accum,
   *accum = _mm_xor_si128(*accum, data);
 }
 
-// Helper functions for hashing an array of __m128i `accum` and a
-// single __m128i `extra` down into `accum[0]` using the random bits
-// in `r128`.
-static inline void clArrayCombineExtra2(const __m128i r128, __m128i *accum,
-                                        const __m128i extra) {
-  clCombine(r128, &accum[0], extra);
-  clCombine(r128, &accum[0], accum[1]);
+static inline __m128i clCombineFar(const __m128i r128, const __m128i x,
+                                   const __m128i y) {
+  __m128i result = _mm_xor_si128(x, r128);
+  result = _mm_clmulepi64_si128(result, result, 1);
+  result = _mm_xor_si128(result, y);
+  return result;
 }
 
-static inline void clArrayCombineExtra3(const __m128i r128, __m128i *accum,
-                                        const __m128i extra) {
-  clCombine(r128, &accum[0], extra);
-  clCombine(r128, &accum[1], accum[2]);
-  clCombine(r128, &accum[0], accum[1]);
-}
+#ifdef __cplusplus
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <x86intrin.h>
+
+// The unrolled families below are templates over the unroll depth
+// MANY, the number of independent accumulators.
+// BigEndianUnrollSelector picks one depth per range of lengths, from
+// a fixed table or, on request, by timing them on the running CPU.
 
-static inline void clArrayCombineExtra4(const __m128i r128, __m128i *accum,
-                                        const __m128i extra) {
-  for (size_t i = 0; i < 2; ++i) {
-    clCombine(r128, &accum[i], accum[i + 2]);
+// Horner's method can only dispatch one 128-bit multiplication at a
+// time, since each loop iteration depends on the one before
+// it. unrolledHorner changes the order in which the words are hashed
+// and can hash multiple words simultaneously, if the processor
+// supports it.
+template <size_t MANY>
+uint64_t unrolledHorner(const void *randomSource, const uint64_t *x,
+                        const size_t length) {
+  static_assert(MANY >= 2, "unrolledHorner needs at least two accumulators");
+  const uint64_t *r64 = (const uint64_t *)randomSource;
+  uint64_t accums[MANY];
+  // the length goes first, ahead of x[0], so that no string is a
+  // prefix of any other
+  accums[0] = length;
+  if (length > 0) {
+    univHash(r64[0], r64[1], x[0], &accums[0]);
+  }
+  for (size_t i = 1; i < MANY; ++i) {
+    accums[i] = (i < length) ? x[i] : 0;
+  }
+  size_t i = (length < MANY) ? length : MANY;
+  for (; i + MANY <= length; i += MANY) {
+    for (size_t j = 0; j < MANY; ++j) {
+      univHash(r64[0], r64[1], x[i + j], &accums[j]);
+    }
+  }
+  for (size_t j = 0; i + j < length; j += 1) {
+    univHash(r64[0], r64[1], x[i + j], &accums[j]);
+  }
+  for (size_t j = 1; j < MANY; ++j) {
+    univHash(r64[0], r64[1], accums[j], &accums[0]);
   }
-  clArrayCombineExtra2(r128, accum, extra);
+  return accums[0] * (r64[2] | ((uint64_t)1));
 }
 
-static inline void clArrayCombineExtra5(const __m128i r128, __m128i *accum,
-                                        const __m128i extra) {
-  clCombine(r128, &accum[0], extra);
-  for (size_t i = 1; i <= 2; ++i) {
-    clCombine(r128, &accum[i], accum[i + 2]);
+// Hashes an array of MANY __m128i `accum` and a single __m128i `extra`
+// down into `accum[0]` using the random bits in `r128`. The second
+// half of the array is folded onto the first; with an odd count,
+// `extra` goes into accum[0] first and the middle accumulator becomes
+// the extra word of the next round.
+template <size_t MANY>
+struct ClArrayCombine {
+  static inline void combine(const __m128i r128, __m128i *accum,
+                             const __m128i extra) {
+    if (MANY % 2 == 0) {
+      for (size_t i = 0; i < MANY / 2; ++i) {
+        clCombine(r128, &accum[i], accum[i + MANY / 2]);
+      }
+      ClArrayCombine<MANY / 2>::combine(r128, accum, extra);
+    } else {
+      clCombine(r128, &accum[0], extra);
+      for (size_t i = 1; i <= MANY / 2; ++i) {
+        clCombine(r128, &accum[i], accum[i + MANY / 2]);
+      }
+      ClArrayCombine<MANY / 2>::combine(r128, accum, accum[MANY / 2]);
+    }
   }
-  clArrayCombineExtra2(r128, accum, accum[2]);
-}
+};
 
-static inline void clArrayCombineExtra6(const __m128i r128, __m128i *accum,
-                                        const __m128i extra) {
-  for (size_t i = 0; i < 3; ++i) {
-    clCombine(r128, &accum[i], accum[i + 3]);
+template <>
+struct ClArrayCombine<1> {
+  static inline void combine(const __m128i r128, __m128i *accum,
+                             const __m128i extra) {
+    clCombine(r128, &accum[0], extra);
+  }
+};
+
+template <>
+struct ClArrayCombine<2> {
+  static inline void combine(const __m128i r128, __m128i *accum,
+                             const __m128i extra) {
+    clCombine(r128, &accum[0], extra);
+    clCombine(r128, &accum[0], accum[1]);
   }
-  clArrayCombineExtra3(r128, accum, extra);
+};
+
+template <size_t MANY>
+static inline void clArrayCombineExtra(const __m128i r128, __m128i *accum,
+                                       const __m128i extra) {
+  ClArrayCombine<MANY>::combine(r128, accum, extra);
 }
 
-static inline void clArrayCombineExtra8(const __m128i r128, __m128i *accum,
-                                        const __m128i extra) {
-  for (size_t i = 0; i < 4; ++i) {
-    clCombine(r128, &accum[i], accum[i + 4]);
+// Iterated hashing using the CLNH family
+template <size_t MANY>
+uint64_t iterateCL(const void *randomSource, const uint64_t *x,
+                   const size_t length) {
+  const uint64_t *r64 = &(((const uint64_t *)(randomSource))[2]);
+  const __m128i *z = (const __m128i *)x;
+  const size_t zlen = length / 2;
+  __m128i accum[MANY];
+  for (size_t j = 0; j < MANY; ++j) {
+    accum[j] = (j < zlen) ? _mm_lddqu_si128(&z[j]) : _mm_setzero_si128();
   }
-  clArrayCombineExtra4(r128, accum, extra);
+  size_t i = (zlen >= MANY) ? MANY : zlen;
+  const __m128i r128 = _mm_lddqu_si128((const __m128i *)randomSource);
+  for (; i + MANY <= zlen; i += MANY) {
+    for (size_t j = 0; j < MANY; ++j) {
+      clCombine(r128, &accum[j], _mm_lddqu_si128(&z[i + j]));
+    }
+  }
+  for (size_t j = 0; j < MANY; ++j) {
+    if (i + j < zlen) {
+      clCombine(r128, &accum[j], _mm_lddqu_si128(&z[i + j]));
+    }
+  }
+  clArrayCombineExtra<MANY>(
+      r128, accum, _mm_set_epi64x(length, (length & 1) ? x[length - 1] : 0));
+  const uint64_t bhd = bigHashDown(r64, &accum[0]);
+  return bie(r64[2], bhd);
 }
 
-static inline void clArrayCombineExtra9(const __m128i r128, __m128i *accum,
-                                        const __m128i extra) {
-  clCombine(r128, &accum[0], extra);
-  for (size_t i = 1; i <= 4; ++i) {
-    clCombine(r128, &accum[i], accum[i + 4]);
+// Unrolled Carter & Wegman tree-hash with clCombineFar as the
+// reducing function. This is basically "Badger - A Fast and Provably
+// Secure MAC", by Boesgaard et al.
+
+template <size_t MANY>
+static inline void halve(const __m128i r128, const __m128i *from,
+                         __m128i *to) {
+  for (size_t i = 0; i < MANY; ++i) {
+    to[i] = clCombineFar(r128, from[2 * i], from[2 * i + 1]);
   }
-  clArrayCombineExtra4(r128, accum, accum[4]);
 }
 
-static inline void clArrayCombineExtra10(const __m128i r128, __m128i *accum,
-                                         const __m128i extra) {
-  for (size_t i = 0; i < 5; ++i) {
-    clCombine(r128, &accum[i], accum[i + 5]);
+template <size_t MANY>
+static inline void halveLoad(const __m128i r128, const __m128i *from,
+                             __m128i *to) {
+  for (size_t i = 0; i < MANY; ++i) {
+    to[i] = clCombineFar(r128, _mm_lddqu_si128(&from[2 * i]),
+                         _mm_lddqu_si128(&from[2 * i + 1]));
   }
-  clArrayCombineExtra5(r128, accum, extra);
 }
 
-static inline void clArrayCombineExtra11(const __m128i r128, __m128i *accum,
-                                         const __m128i extra) {
-  clCombine(r128, &accum[0], extra);
-  for (size_t i = 1; i <= 5; ++i) {
-    clCombine(r128, &accum[i], accum[i + 5]);
+template <size_t MANY>
+uint64_t treeCL(const void *randomSource, const uint64_t *x,
+                const size_t length) {
+  const __m128i *r128 = (const __m128i *)randomSource;
+  const size_t depth = 64 - __builtin_clzll(1 + length);
+  __m128i rLevel[64];
+  for (size_t i = 0; i < depth; ++i) {
+    rLevel[i] = _mm_lddqu_si128(&r128[i]);
+  }
+  __m128i tree[64][2 * MANY];
+  size_t fill[64];
+  for (size_t i = 0; i < 64; ++i) {
+    fill[i] = 0;
+  }
+  const __m128i *z = (const __m128i *)x;
+  const size_t zlen = length / 2;
+  size_t i = 0;
+  for (; i + 2 * MANY <= zlen; i += 2 * MANY) {
+    for (size_t j = 0; 2 * MANY == fill[j]; ++j) {
+      halve<MANY>(rLevel[j + 1], tree[j], &tree[j + 1][fill[j + 1]]);
+      fill[j] = 0;
+      fill[j + 1] += MANY;
+    }
+    halveLoad<MANY>(rLevel[0], &z[i], &tree[0][fill[0]]);
+    fill[0] += MANY;
+  }
+  size_t max_fill_level = depth - 1;
+  for (; fill[max_fill_level] > 0; --max_fill_level) {
   }
-  clArrayCombineExtra5(r128, accum, accum[5]);
+  for (size_t j = 0; 2 * MANY == fill[j]; ++j) {
+    halve<MANY>(rLevel[j + 1], tree[j], &tree[j + 1][fill[j + 1]]);
+    fill[j] = 0;
+    fill[j + 1] += MANY;
+  }
+  // the remaining whole pairs of 128-bit words; an odd one is paired
+  // with the final word below
+  for (; i + 2 <= zlen; i += 2) {
+    tree[0][fill[0]] = clCombineFar(rLevel[0], _mm_lddqu_si128(&z[i]),
+                                    _mm_lddqu_si128(&z[i + 1]));
+    ++fill[0];
+  }
+  const __m128i final =
+      _mm_set_epi64x(length, (length & 1) ? x[length - 1] : 0);
+  tree[0][fill[0]] =
+      (i < zlen) ? clCombineFar(rLevel[0], _mm_lddqu_si128(&z[i]), final)
+                 : final;
+  ++fill[0];
+  i = 0;
+  for (; (i < max_fill_level) || (fill[i] > 1); ++i) {
+    size_t j = 0;
+    for (; j + 2 <= fill[i]; j += 2) {
+      tree[i + 1][fill[i + 1]] =
+          clCombineFar(rLevel[i + 1], tree[i][j], tree[i][j + 1]);
+      ++fill[i + 1];
+    }
+    if (j < fill[i]) {
+      tree[i + 1][fill[i + 1]] = tree[i][j];
+      ++fill[i + 1];
+    }
+  }
+  const uint64_t *r64 = (const uint64_t *)randomSource;
+  r64 += 2 * MANY;
+  const uint64_t bhd = bigHashDown(r64, &tree[i][0]);
+  return bie(r64[2], bhd);
 }
 
-static inline void clArrayCombineExtra12(const __m128i r128, __m128i *accum,
-                                         const __m128i extra) {
-  for (size_t i = 0; i < 6; ++i) {
-    clCombine(r128, &accum[i], accum[i + 6]);
+// One unroll depth of a family
+struct UnrollCandidate {
+  size_t depth;
+  uint64_t (*hash)(const void *, const uint64_t *, const size_t);
+};
+
+static const UnrollCandidate unrolledHornerCandidates[] = {
+    {3, &unrolledHorner<3>}, {4, &unrolledHorner<4>}, {5, &unrolledHorner<5>},
+    {6, &unrolledHorner<6>}, {7, &unrolledHorner<7>}, {8, &unrolledHorner<8>},
+    {9, &unrolledHorner<9>}};
+
+static const UnrollCandidate iterateCLCandidates[] = {
+    {8, &iterateCL<8>}, {9, &iterateCL<9>}, {10, &iterateCL<10>},
+    {11, &iterateCL<11>}, {12, &iterateCL<12>}};
+
+static const UnrollCandidate treeCLCandidates[] = {
+    {8, &treeCL<8>}, {9, &treeCL<9>}, {10, &treeCL<10>}};
+
+// Hashes each range of lengths with one candidate of a family, either
+// at depths given by the caller or at the fastest depths found by
+// timing every candidate on the running CPU (a few milliseconds). A
+// timed choice depends on the CPU and on timing noise, not on the key,
+// so its hash values can differ between machines and between runs:
+// that is for in-memory tables, not for stored hashes. Strings in
+// different ranges can be hashed at different depths, so the bound of
+// the family holds between strings of the same range.
+class BigEndianUnrollSelector {
+public:
+  // lengths (in words) below 8, 32, 128, 512, and the rest
+  static const size_t RANGES = 5;
+
+  // the depth for each range of lengths
+  struct Depths {
+    size_t depth[RANGES];
+  };
+
+  static size_t range(const size_t length) {
+    size_t r = 0;
+    for (size_t limit = 8; (r + 1 < RANGES) && (length >= limit); limit *= 4) {
+      ++r;
+    }
+    return r;
   }
-  clArrayCombineExtra6(r128, accum, extra);
-}
 
-// Iterated hashing using the CLNH family
-#define ITERATECL(MANY)                                                     \
-  uint64_t iterateCL##MANY(const void *randomSource, const uint64_t *x,     \
-                           const size_t length) {                           \
-    const uint64_t *r64 = &(((const uint64_t *)(randomSource))[2]);         \
-    const __m128i *z = (const __m128i *)x;                                  \
-    const size_t zlen = length / 2;                                         \
-    __m128i accum[MANY];                                                    \
-    for (size_t j = 0; j < MANY; ++j) {                                     \
-      accum[j] = (j < zlen) ? _mm_lddqu_si128(&z[j]) : _mm_setzero_si128(); \
-    }                                                                       \
-    size_t i = (zlen >= MANY) ? MANY : zlen;                                \
-    const __m128i r128 = _mm_lddqu_si128((const __m128i *)randomSource);    \
-    for (; i + MANY <= zlen; i += MANY) {                                   \
-      for (size_t j = 0; j < MANY; ++j) {                                   \
-        clCombine(r128, &accum[j], _mm_lddqu_si128(&z[i + j]));             \
-      }                                                                     \
-    }                                                                       \
-    for (size_t j = 0; j < MANY; ++j) {                                     \
-      if (i + j < zlen) {                                                   \
-        clCombine(r128, &accum[j], _mm_lddqu_si128(&z[i + j]));             \
-      }                                                                     \
-    }                                                                       \
-    clArrayCombineExtra##MANY(                                              \
-        r128, accum,                                                        \
-        _mm_set_epi64x(length, (length & 1) ? x[length - 1] : 0));          \
-    const uint64_t bhd = bigHashDown(r64, &accum[0]);                       \
-    return bie(r64[2], bhd);                                                \
-  }
-
-ITERATECL(8)
-ITERATECL(9)
-ITERATECL(10)
-ITERATECL(11)
-ITERATECL(12)
-
-#undef ITERATECL
+  // every depth must be one of the candidates
+  BigEndianUnrollSelector(const UnrollCandidate *candidates, const size_t count,
+                          const Depths &depths) {
+    for (size_t r = 0; r < RANGES; ++r) {
+      chosen[r] = candidates[0];
+      for (size_t c = 0; c < count; ++c) {
+        if (candidates[c].depth == depths.depth[r]) chosen[r] = candidates[c];
+      }
+      assert(chosen[r].depth == depths.depth[r]);
+    }
+  }
 
-static inline __m128i clCombineFar(const __m128i r128, const __m128i x,
-                                   const __m128i y) {
-  __m128i result = _mm_xor_si128(x, r128);
-  result = _mm_clmulepi64_si128(result, result, 1);
-  result = _mm_xor_si128(result, y);
-  return result;
-}
+  // times the candidates; randomSource must be valid for every
+  // candidate, as for hashing
+  BigEndianUnrollSelector(const UnrollCandidate *candidates, const size_t count,
+                          const void *randomSource) {
+    static const size_t lengths[RANGES] = {4, 16, 64, 256, 2048};
+    std::vector<uint64_t> input(2048);
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    for (size_t i = 0; i < input.size(); ++i) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      input[i] = state;
+    }
+    for (size_t r = 0; r < RANGES; ++r) {
+      const size_t repeats = 1 + 8192 / lengths[r];
+      uint64_t best = ~(uint64_t)0;
+      chosen[r] = candidates[0];
+      for (size_t c = 0; c < count; ++c) {
+        uint64_t fastest = ~(uint64_t)0;
+        for (int trial = 0; trial < 5; ++trial) {
+          uint64_t sum = 0;
+          const uint64_t before = __rdtsc();
+          for (size_t k = 0; k < repeats; ++k) {
+            sum += candidates[c].hash(randomSource, input.data(), lengths[r]);
+            input[0] += sum; // keeps the calls from being merged
+          }
+          const uint64_t elapsed = __rdtsc() - before;
+          if (elapsed < fastest) fastest = elapsed;
+        }
+        if (fastest < best) {
+          best = fastest;
+          chosen[r] = candidates[c];
+        }
+      }
+    }
+  }
 
-// Unrolled Carter & Wegman tree-hash with clCombineFar as the
-// reducing function. This is basically "Badger - A Fast and Provably
-// Secure MAC", by Boesgaard et al.
+  uint64_t hash(const void *randomSource, const uint64_t *x,
+                const size_t length) const {
+    return chosen[range(length)].hash(randomSource, x, length);
+  }
 
-#define HALVE(MANY)                                                       \
-  static inline void halve##MANY(const __m128i r128, const __m128i *from, \
-                                 __m128i *to) {                           \
-    for (size_t i = 0; i < MANY; ++i) {                                   \
-      to[i] = clCombineFar(r128, from[2 * i], from[2 * i + 1]);           \
-    }                                                                     \
+  // the depth used for lengths in range r
+  size_t depth(const size_t r) const { return chosen[r].depth; }
+
+  // Parses text as one depth for every range or as RANGES
+  // comma-separated depths, each of them one of the candidates; false
+  // (with depths unchanged) when it is anything else.
+  static bool parseDepths(const char *text, const UnrollCandidate *candidates,
+                          const size_t count, Depths *depths) {
+    Depths parsed;
+    size_t r = 0;
+    for (; r < RANGES; ++r) {
+      char *end;
+      parsed.depth[r] = strtoul(text, &end, 10);
+      bool known = false;
+      for (size_t c = 0; c < count; ++c) {
+        known = known || (candidates[c].depth == parsed.depth[r]);
+      }
+      if ((end == text) || !known) return false;
+      text = end;
+      if (*text != ',') break;
+      ++text;
+    }
+    if (*text != '\0') return false;
+    if (r == 0) {
+      for (r = 1; r < RANGES; ++r) parsed.depth[r] = parsed.depth[0];
+    } else if (r + 1 != RANGES) {
+      return false;
+    }
+    *depths = parsed;
+    return true;
   }
 
-#define HALVE_LOAD(MANY)                                                      \
-  static inline void halveLoad##MANY(const __m128i r128, const __m128i *from, \
-                                     __m128i *to) {                           \
-    for (size_t i = 0; i < MANY; ++i) {                                       \
-      to[i] = clCombineFar(r128, _mm_lddqu_si128(&from[2 * i]),               \
-                           _mm_lddqu_si128(&from[2 * i + 1]));                \
-    }                                                                         \
+private:
+  UnrollCandidate chosen[RANGES];
+};
+
+// The default depths of the families below, for lengths below 8, 32,
+// 128, 512 words and the rest: the depths the timed selector picked
+// most often in 1001 runs on an AVX-512 Xeon, as recorded in
+// analysis/tuning/bigendian-unroll-depths.txt (rerun
+// analysis/tuning/bigendian-unroll-depths.cc for another CPU). The
+// families do not time themselves by default: single timed picks differ
+// from run to run where depths are close (see treeCL above 128 words in
+// that file), and each change of depth changes the hash values.
+static const BigEndianUnrollSelector::Depths unrolledHornerDefaultDepths = {{4, 3, 8, 8, 8}};
+static const BigEndianUnrollSelector::Depths iterateCLDefaultDepths = {{10, 10, 11, 12, 12}};
+static const BigEndianUnrollSelector::Depths treeCLDefaultDepths = {{8, 8, 8, 8, 9}};
+
+// The selector for a family: the environment variable named variable
+// can give other depths (as in parseDepths), or "tune" to time the
+// candidates on this CPU; otherwise the family keeps its defaults. Any
+// other value is reported on stderr and aborts.
+static inline BigEndianUnrollSelector selectUnrollDepths(
+    const UnrollCandidate *candidates, const size_t count,
+    const BigEndianUnrollSelector::Depths &defaults, const char *variable,
+    const void *randomSource) {
+  const char *setting = getenv(variable);
+  if ((setting != NULL) && (strcmp(setting, "tune") == 0)) {
+    return BigEndianUnrollSelector(candidates, count, randomSource);
+  }
+  BigEndianUnrollSelector::Depths depths = defaults;
+  if ((setting != NULL) &&
+      !BigEndianUnrollSelector::parseDepths(setting, candidates, count, &depths)) {
+    fprintf(stderr,
+            "%s=\"%s\" is neither \"tune\", one depth nor %zu "
+            "comma-separated depths of this family\n",
+            variable, setting, BigEndianUnrollSelector::RANGES);
+    abort();
   }
+  return BigEndianUnrollSelector(candidates, count, depths);
+}
 
-#define TREECL(MANY)                                                        \
-  uint64_t treeCL##MANY(const void *randomSource, const uint64_t *x,        \
-                        const size_t length) {                              \
-    const __m128i *r128 = (const __m128i *)randomSource;                    \
-    const size_t depth = 64 - __builtin_clzll(1 + length);                  \
-    __m128i rLevel[64];                                                     \
-    for (size_t i = 0; i < depth; ++i) {                                    \
-      rLevel[i] = _mm_lddqu_si128(&r128[i]);                                \
-    }                                                                       \
-    __m128i tree[64][2 * MANY];                                             \
-    size_t fill[64];                                                        \
-    for (size_t i = 0; i < depth; ++i) {                                    \
-      fill[i] = 0;                                                          \
-    }                                                                       \
-    const __m128i *z = (const __m128i *)x;                                  \
-    const size_t zlen = length / 2;                                         \
-    size_t i = 0;                                                           \
-    for (; i + 2 * MANY <= zlen; i += 2 * MANY) {                           \
-      for (size_t j = 0; 2 * MANY == fill[j]; ++j) {                        \
-        halve##MANY(rLevel[j + 1], tree[j], &tree[j + 1][fill[j + 1]]);     \
-        fill[j] = 0;                                                        \
-        fill[j + 1] += MANY;                                                \
-      }                                                                     \
-      halveLoad##MANY(rLevel[0], &z[i], &tree[0][fill[0]]);                 \
-      fill[0] += MANY;                                                      \
-    }                                                                       \
-    size_t max_fill_level = depth - 1;                                      \
-    for (; fill[max_fill_level] > 0; --max_fill_level) {                    \
-    }                                                                       \
-    for (size_t j = 0; 2 * MANY == fill[j]; ++j) {                          \
-      halve##MANY(rLevel[j + 1], tree[j], &tree[j + 1][fill[j + 1]]);       \
-      fill[j] = 0;                                                          \
-      fill[j + 1] += MANY;                                                  \
-    }                                                                       \
-    for (; i < zlen; i += 2) {                                              \
-      tree[0][fill[0]] = clCombineFar(rLevel[0], _mm_lddqu_si128(&z[i]),    \
-                                      _mm_lddqu_si128(&z[i + 1]));          \
-      ++fill[0];                                                            \
-    }                                                                       \
-    const __m128i final =                                                   \
-        _mm_set_epi64x(length, (length & 1) ? x[length - 1] : 0);           \
-    tree[0][fill[0]] =                                                      \
-        (i < zlen) ? clCombineFar(rLevel[0], _mm_lddqu_si128(&z[i]), final) \
-                   : final;                                                 \
-    ++fill[0];                                                              \
-    i = 0;                                                                  \
-    for (; (i < max_fill_level) || (fill[i] > 1); ++i) {                    \
-      size_t j = 0;                                                         \
-      for (; j + 2 <= fill[i]; j += 2) {                                    \
-        tree[i + 1][fill[i + 1]] =                                          \
-            clCombineFar(rLevel[i + 1], tree[i][j], tree[i][j + 1]);        \
-        ++fill[i + 1];                                                      \
-      }                                                                     \
-      if (j < fill[i]) {                                                    \
-        tree[i + 1][fill[i + 1]] = tree[i][j];                              \
-        ++fill[i + 1];                                                      \
-      }                                                                     \
-    }                                                                       \
-    const uint64_t *r64 = (const uint64_t *)randomSource;                   \
-    r64 += 2 * MANY;                                                        \
-    const uint64_t bhd = bigHashDown(r64, &tree[i][0]);                     \
-    return bie(r64[2], bhd);                                                \
-  }
-
-#define TREECLALL(MANY) HALVE(MANY) HALVE_LOAD(MANY) TREECL(MANY)
-
-TREECLALL(8)
-TREECLALL(9)
-TREECLALL(10)
+// The families as hash functions, with the depths chosen by
+// selectUnrollDepths on their first call: BIGENDIAN_UNROLLED_HORNER_DEPTHS,
+// BIGENDIAN_ITERATE_CL_DEPTHS and BIGENDIAN_TREE_CL_DEPTHS override the
+// defaults. Two inputs whose lengths fall in different ranges may be
+// hashed at different depths, that is, by different hash functions: the
+// collision bound of the family only holds for inputs whose lengths fall
+// in the same range (or when one depth is given for every range).
+uint64_t unrolledHornerSelected(const void *randomSource, const uint64_t *x,
+                                const size_t length) {
+  static const BigEndianUnrollSelector selector = selectUnrollDepths(
+      unrolledHornerCandidates,
+      sizeof(unrolledHornerCandidates) / sizeof(unrolledHornerCandidates[0]),
+      unrolledHornerDefaultDepths, "BIGENDIAN_UNROLLED_HORNER_DEPTHS",
+      randomSource);
+  return selector.hash(randomSource, x, length);
+}
+
+uint64_t iterateCLSelected(const void *randomSource, const uint64_t *x,
+                           const size_t length) {
+  static const BigEndianUnrollSelector selector = selectUnrollDepths(
+      iterateCLCandidates,
+      sizeof(iterateCLCandidates) / sizeof(iterateCLCandidates[0]),
+      iterateCLDefaultDepths, "BIGENDIAN_ITERATE_CL_DEPTHS", randomSource);
+  return selector.hash(randomSource, x, length);
+}
+
+uint64_t treeCLSelected(const void *randomSource, const uint64_t *x,
+                        const size_t length) {
+  static const BigEndianUnrollSelector selector = selectUnrollDepths(
+      treeCLCandidates, sizeof(treeCLCandidates) / sizeof(treeCLCandidates[0]),
+      treeCLDefaultDepths, "BIGENDIAN_TREE_CL_DEPTHS", randomSource);
+  return selector.hash(randomSource, x, length);
+}
+#endif  // __cplusplus
 
 #endif  // BIGENDIANUNIVERSAL_H
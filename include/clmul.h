@@ -24,6 +24,34 @@
 #include <smmintrin.h>
 ///////// End of compatibility hack.
 
+//////////////////
+// CLMUL_WIDE is the register width (256 or 512 bits, 0 for none) of the VPCLMULQDQ forms
+// of the kernels below: by default, the widest that the target supports. Define it to 0
+// (or 256) to build the narrower forms instead.
+//
+// CLMUL_KARATSUBA selects the 128x128-bit products used by CLHASH, GHASH and the
+// aggregated kernels: three CLMULs (Karatsuba) when it is 1, four (schoolbook) otherwise.
+// Both give the same products.
+//////////////////
+#ifndef CLMUL_WIDE
+#if defined(__VPCLMULQDQ__) && defined(__AVX512F__) && defined(__AVX512BW__)
+#define CLMUL_WIDE 512
+#elif defined(__VPCLMULQDQ__) && defined(__AVX2__)
+#define CLMUL_WIDE 256
+#else
+#define CLMUL_WIDE 0
+#endif
+#endif
+
+#ifndef CLMUL_KARATSUBA
+#define CLMUL_KARATSUBA 0
+#endif
+
+#if CLMUL_WIDE || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "avx512diagnostics.h"
+
 void printme32(__m128i v1) {
     printf(" %u %u %u %u  ", _mm_extract_epi32(v1,0), _mm_extract_epi32(v1,1), _mm_extract_epi32(v1,2), _mm_extract_epi32(v1,3));
 }
@@ -79,19 +107,192 @@ __m128i lazymod127(__m128i Alow, __m128i Ahigh) {
 }
 
 
+//////////////////
+// Carry-less 128x128-bit products without reduction, as 256-bit values (Ahigh:Alow).
+// Sums of products are accumulated in three 128-bit parts (lo, mid, hi) that are
+// combined once, so that an aggregated product needs a single combination and then a
+// single reduction by the caller.
+//////////////////
+
+// four CLMULs (Gueron and Kounavis, fig. 5)
+static inline void mul128by128to256_schoolbook(__m128i A, __m128i B, __m128i * Alow, __m128i * Ahigh) {
+    const __m128i Amix = _mm_xor_si128(_mm_clmulepi64_si128(A,B,0x01), _mm_clmulepi64_si128(A,B,0x10));
+    *Alow = _mm_xor_si128(_mm_clmulepi64_si128(A,B,0x00), _mm_slli_si128(Amix,8));
+    *Ahigh = _mm_xor_si128(_mm_clmulepi64_si128(A,B,0x11), _mm_srli_si128(Amix,8));
+}
+
+// three CLMULs (Karatsuba, fig. 7): the middle term is (A1+A0)*(B1+B0) + A1*B1 + A0*B0
+static inline void mul128by128to256_karatsuba(__m128i A, __m128i B, __m128i * Alow, __m128i * Ahigh) {
+    const __m128i lo = _mm_clmulepi64_si128(A,B,0x00);
+    const __m128i hi = _mm_clmulepi64_si128(A,B,0x11);
+    __m128i Amix = _mm_clmulepi64_si128(_mm_xor_si128(A,_mm_shuffle_epi32(A,78)),
+                                        _mm_xor_si128(B,_mm_shuffle_epi32(B,78)), 0x00);
+    Amix = _mm_xor_si128(Amix, _mm_xor_si128(lo, hi));
+    *Alow = _mm_xor_si128(lo, _mm_slli_si128(Amix,8));
+    *Ahigh = _mm_xor_si128(hi, _mm_srli_si128(Amix,8));
+}
+
+// adds A * B to the parts (lo, mid, hi), in the form selected by CLMUL_KARATSUBA
+static inline void clmul128_accumulate(__m128i A, __m128i B, __m128i * lo, __m128i * mid, __m128i * hi) {
+    *lo = _mm_xor_si128(*lo, _mm_clmulepi64_si128(A,B,0x00));
+    *hi = _mm_xor_si128(*hi, _mm_clmulepi64_si128(A,B,0x11));
+#if CLMUL_KARATSUBA
+    *mid = _mm_xor_si128(*mid, _mm_clmulepi64_si128(_mm_xor_si128(A,_mm_shuffle_epi32(A,78)),
+                                                    _mm_xor_si128(B,_mm_shuffle_epi32(B,78)), 0x00));
+#else
+    *mid = _mm_xor_si128(*mid, _mm_xor_si128(_mm_clmulepi64_si128(A,B,0x01), _mm_clmulepi64_si128(A,B,0x10)));
+#endif
+}
+
+// the 256-bit sum (Ahigh:Alow) of the products accumulated in (lo, mid, hi)
+static inline void clmul128_combine(__m128i lo, __m128i mid, __m128i hi, __m128i * Alow, __m128i * Ahigh) {
+#if CLMUL_KARATSUBA
+    mid = _mm_xor_si128(mid, _mm_xor_si128(lo, hi));
+#endif
+    *Alow = _mm_xor_si128(lo, _mm_slli_si128(mid,8));
+    *Ahigh = _mm_xor_si128(hi, _mm_srli_si128(mid,8));
+}
+
+// A * B in the form selected by CLMUL_KARATSUBA
+static inline void mul128by128to256_clmul(__m128i A, __m128i B, __m128i * Alow, __m128i * Ahigh) {
+#if CLMUL_KARATSUBA
+    mul128by128to256_karatsuba(A, B, Alow, Ahigh);
+#else
+    mul128by128to256_schoolbook(A, B, Alow, Ahigh);
+#endif
+}
+
+// A1 * B1 + A2 * B2
+static inline void mul128by128to256_2by2(__m128i A1, __m128i A2, __m128i B1, __m128i B2,
+        __m128i * Alow, __m128i * Ahigh) {
+    __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    clmul128_accumulate(A1, B1, &lo, &mid, &hi);
+    clmul128_accumulate(A2, B2, &lo, &mid, &hi);
+    clmul128_combine(lo, mid, hi, Alow, Ahigh);
+}
+
+// A1 * B1 + A2 * B2 + A3 * B3 + A4 * B4
+static inline void mul128by128to256_4by4(__m128i A1, __m128i A2, __m128i A3, __m128i A4,
+        __m128i B1, __m128i B2, __m128i B3, __m128i B4, __m128i * Alow, __m128i * Ahigh) {
+    __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    clmul128_accumulate(A1, B1, &lo, &mid, &hi);
+    clmul128_accumulate(A2, B2, &lo, &mid, &hi);
+    clmul128_accumulate(A3, B3, &lo, &mid, &hi);
+    clmul128_accumulate(A4, B4, &lo, &mid, &hi);
+    clmul128_combine(lo, mid, hi, Alow, Ahigh);
+}
+
+AVX512_KERNELS_BEGIN
+
+#if CLMUL_WIDE
+// clmul128_accumulate on each 128-bit lane: two (ymm) or four (zmm) products at once
+static inline void clmul128_accumulate_si256(__m256i A, __m256i B, __m256i * lo, __m256i * mid, __m256i * hi) {
+    *lo = _mm256_xor_si256(*lo, _mm256_clmulepi64_epi128(A,B,0x00));
+    *hi = _mm256_xor_si256(*hi, _mm256_clmulepi64_epi128(A,B,0x11));
+#if CLMUL_KARATSUBA
+    *mid = _mm256_xor_si256(*mid, _mm256_clmulepi64_epi128(_mm256_xor_si256(A,_mm256_shuffle_epi32(A,78)),
+                                                           _mm256_xor_si256(B,_mm256_shuffle_epi32(B,78)), 0x00));
+#else
+    *mid = _mm256_xor_si256(*mid, _mm256_xor_si256(_mm256_clmulepi64_epi128(A,B,0x01),
+                                                   _mm256_clmulepi64_epi128(A,B,0x10)));
+#endif
+}
+
+// the xor of the two lanes
+static inline __m128i clmul_fold256(__m256i x) {
+    return _mm_xor_si128(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+}
+
+// clmul128_combine on each lane: one 256-bit product per lane, as (Ahigh:Alow) lane by lane
+static inline void clmul128_combine_si256(__m256i lo, __m256i mid, __m256i hi, __m256i * Alow, __m256i * Ahigh) {
+#if CLMUL_KARATSUBA
+    mid = _mm256_xor_si256(mid, _mm256_xor_si256(lo, hi));
+#endif
+    *Alow = _mm256_xor_si256(lo, _mm256_bslli_epi128(mid,8));
+    *Ahigh = _mm256_xor_si256(hi, _mm256_bsrli_epi128(mid,8));
+}
+
+// two independent products, one per lane
+static inline void mul128by128to256_si256(__m256i A, __m256i B, __m256i * Alow, __m256i * Ahigh) {
+    __m256i lo = _mm256_setzero_si256(), mid = _mm256_setzero_si256(), hi = _mm256_setzero_si256();
+    clmul128_accumulate_si256(A, B, &lo, &mid, &hi);
+    clmul128_combine_si256(lo, mid, hi, Alow, Ahigh);
+}
+
+#if CLMUL_WIDE == 512
+static inline void clmul128_accumulate_si512(__m512i A, __m512i B, __m512i * lo, __m512i * mid, __m512i * hi) {
+    *lo = _mm512_xor_si512(*lo, _mm512_clmulepi64_epi128(A,B,0x00));
+    *hi = _mm512_xor_si512(*hi, _mm512_clmulepi64_epi128(A,B,0x11));
+#if CLMUL_KARATSUBA
+    *mid = _mm512_xor_si512(*mid, _mm512_clmulepi64_epi128(_mm512_xor_si512(A,_mm512_shuffle_epi32(A,78)),
+                                                           _mm512_xor_si512(B,_mm512_shuffle_epi32(B,78)), 0x00));
+#else
+    *mid = _mm512_xor_si512(*mid, _mm512_xor_si512(_mm512_clmulepi64_epi128(A,B,0x01),
+                                                   _mm512_clmulepi64_epi128(A,B,0x10)));
+#endif
+}
+
+// the xor of the two 256-bit halves
+static inline __m256i clmul_fold512(__m512i x) {
+    return _mm256_xor_si256(_mm512_castsi512_si256(x), _mm512_extracti64x4_epi64(x, 1));
+}
+
+static inline void clmul128_combine_si512(__m512i lo, __m512i mid, __m512i hi, __m512i * Alow, __m512i * Ahigh) {
+#if CLMUL_KARATSUBA
+    mid = _mm512_xor_si512(mid, _mm512_xor_si512(lo, hi));
+#endif
+    *Alow = _mm512_xor_si512(lo, _mm512_bslli_epi128(mid,8));
+    *Ahigh = _mm512_xor_si512(hi, _mm512_bsrli_epi128(mid,8));
+}
+
+// four independent products, one per lane
+static inline void mul128by128to256_si512(__m512i A, __m512i B, __m512i * Alow, __m512i * Ahigh) {
+    __m512i lo = _mm512_setzero_si512(), mid = _mm512_setzero_si512(), hi = _mm512_setzero_si512();
+    clmul128_accumulate_si512(A, B, &lo, &mid, &hi);
+    clmul128_combine_si512(lo, mid, hi, Alow, Ahigh);
+}
+#endif
+#endif
+
+// A[0] * B[0] + ... + A[n-1] * B[n-1] (the arrays need not be aligned), four products per
+// zmm register and two per ymm register as CLMUL_WIDE allows
+static inline void mul128by128to256_sum(const __m128i * A, const __m128i * B, size_t n,
+                                        __m128i * Alow, __m128i * Ahigh) {
+    __m128i lo = _mm_setzero_si128(), mid = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    size_t j = 0;
+#if CLMUL_WIDE
+    __m256i lo256 = _mm256_setzero_si256(), mid256 = _mm256_setzero_si256(), hi256 = _mm256_setzero_si256();
+#if CLMUL_WIDE == 512
+    if (n >= 4) {
+        __m512i lo512 = _mm512_setzero_si512(), mid512 = _mm512_setzero_si512(), hi512 = _mm512_setzero_si512();
+        for (; j + 4 <= n; j += 4)
+            clmul128_accumulate_si512(_mm512_loadu_si512((const void *) (A + j)),
+                                      _mm512_loadu_si512((const void *) (B + j)), &lo512, &mid512, &hi512);
+        lo256 = clmul_fold512(lo512);
+        mid256 = clmul_fold512(mid512);
+        hi256 = clmul_fold512(hi512);
+    }
+#endif
+    for (; j + 2 <= n; j += 2)
+        clmul128_accumulate_si256(_mm256_loadu_si256((const __m256i *) (A + j)),
+                                  _mm256_loadu_si256((const __m256i *) (B + j)), &lo256, &mid256, &hi256);
+    lo = clmul_fold256(lo256);
+    mid = clmul_fold256(mid256);
+    hi = clmul_fold256(hi256);
+#endif
+    for (; j < n; ++j)
+        clmul128_accumulate(_mm_loadu_si128(A + j), _mm_loadu_si128(B + j), &lo, &mid, &hi);
+    clmul128_combine(lo, mid, hi, Alow, Ahigh);
+}
+
+AVX512_KERNELS_END
+
 // multiplication with lazy reduction
 // assumes that the two highest bits of the 256-bit multiplication are zeros
 // returns a lazy reduction
 __m128i mul128by128to128_lazymod127( __m128i A, __m128i B) {
-    __m128i Amix1 = _mm_clmulepi64_si128(A,B,0x01);
-    __m128i Amix2 = _mm_clmulepi64_si128(A,B,0x10);
-    __m128i Alow = _mm_clmulepi64_si128(A,B,0x00);
-    __m128i Ahigh = _mm_clmulepi64_si128(A,B,0x11);
-    __m128i Amix = _mm_xor_si128(Amix1,Amix2);
-    Amix1 = _mm_slli_si128(Amix,8);
-    Amix2 = _mm_srli_si128(Amix,8);
-    Alow = _mm_xor_si128(Alow,Amix1);
-    Ahigh = _mm_xor_si128(Ahigh,Amix2);
+    __m128i Alow, Ahigh;
+    mul128by128to256_clmul(A, B, &Alow, &Ahigh);
     return lazymod127(Alow, Ahigh);
 }
 
@@ -101,24 +302,8 @@ __m128i mul128by128to128_lazymod127( __m128i A, __m128i B) {
 // returns a lazy reduction
 __m128i mul128by128to128_lazymod127_2by2( __m128i A1,__m128i A2,
         __m128i B1,__m128i B2) {
-    __m128i Amix11 = _mm_clmulepi64_si128(A1,B1,0x01);
-    __m128i Amix21 = _mm_clmulepi64_si128(A1,B1,0x10);
-    __m128i Amix12 = _mm_clmulepi64_si128(A2,B2,0x01);
-    __m128i Amix22 = _mm_clmulepi64_si128(A2,B2,0x10);
-    __m128i Alow1 = _mm_clmulepi64_si128(A1,B1,0x00);
-    __m128i Ahigh1 = _mm_clmulepi64_si128(A1,B1,0x11);
-    __m128i Alow2 = _mm_clmulepi64_si128(A2,B2,0x00);
-    __m128i Ahigh2 = _mm_clmulepi64_si128(A2,B2,0x11);
-
-    __m128i Amix1 = _mm_xor_si128(Amix11,Amix21);
-    __m128i Amix2 = _mm_xor_si128(Amix12,Amix22);
-    __m128i Amix = _mm_xor_si128(Amix1,Amix2);
-    Amix1 = _mm_slli_si128(Amix,8);
-    Amix2 = _mm_srli_si128(Amix,8);
-    __m128i Alow = _mm_xor_si128(Alow1,Alow2);
-    __m128i Ahigh = _mm_xor_si128(Ahigh1,Ahigh2);
-    Alow = _mm_xor_si128(Alow,Amix1);
-    Ahigh = _mm_xor_si128(Ahigh,Amix2);
+    __m128i Alow, Ahigh;
+    mul128by128to256_2by2(A1, A2, B1, B2, &Alow, &Ahigh);
     return lazymod127(Alow, Ahigh);
 }
 
@@ -129,49 +314,8 @@ __m128i mul128by128to128_lazymod127_2by2( __m128i A1,__m128i A2,
 // returns a lazy reduction
 __m128i mul128by128to128_lazymod127_4by4( __m128i A1,__m128i A2,__m128i A3,__m128i A4,
         __m128i B1,__m128i B2,__m128i B3,__m128i B4) {
-    __m128i Amix11 = _mm_clmulepi64_si128(A1,B1,0x01);
-    __m128i Amix21 = _mm_clmulepi64_si128(A1,B1,0x10);
-    __m128i Amix12 = _mm_clmulepi64_si128(A2,B2,0x01);
-    __m128i Amix22 = _mm_clmulepi64_si128(A2,B2,0x10);
-    __m128i Amix13 = _mm_clmulepi64_si128(A3,B3,0x01);
-    __m128i Amix23 = _mm_clmulepi64_si128(A3,B3,0x10);
-    __m128i Amix14 = _mm_clmulepi64_si128(A4,B4,0x01);
-    __m128i Amix24 = _mm_clmulepi64_si128(A4,B4,0x10);
-
-    __m128i Alow1 = _mm_clmulepi64_si128(A1,B1,0x00);
-    __m128i Ahigh1 = _mm_clmulepi64_si128(A1,B1,0x11);
-    __m128i Alow2 = _mm_clmulepi64_si128(A2,B2,0x00);
-    __m128i Ahigh2 = _mm_clmulepi64_si128(A2,B2,0x11);
-    __m128i Alow3 = _mm_clmulepi64_si128(A3,B3,0x00);
-    __m128i Ahigh3 = _mm_clmulepi64_si128(A3,B3,0x11);
-    __m128i Alow4 = _mm_clmulepi64_si128(A4,B4,0x00);
-    __m128i Ahigh4 = _mm_clmulepi64_si128(A4,B4,0x11);
-
-
-
-    __m128i Amix1 = _mm_xor_si128(Amix11,Amix21);
-    __m128i Amix2 = _mm_xor_si128(Amix12,Amix22);
-    __m128i Amix3 = _mm_xor_si128(Amix13,Amix23);
-    __m128i Amix4 = _mm_xor_si128(Amix14,Amix24);
-
-    Amix12 = _mm_xor_si128(Amix1,Amix2);
-    Amix23 = _mm_xor_si128(Amix3,Amix4);
-    __m128i Amix = _mm_xor_si128(Amix12,Amix23);
-
-    Amix1 = _mm_slli_si128(Amix,8);
-
-    Amix2 = _mm_srli_si128(Amix,8);
-
-    __m128i Alow12 = _mm_xor_si128(Alow1,Alow2);
-    __m128i Alow34 = _mm_xor_si128(Alow3,Alow4);
-    __m128i Alow = _mm_xor_si128(Alow12,Alow34);
-
-    __m128i Ahigh12 = _mm_xor_si128(Ahigh1,Ahigh2);
-    __m128i Ahigh34 = _mm_xor_si128(Ahigh3,Ahigh4);
-    __m128i Ahigh = _mm_xor_si128(Ahigh12,Ahigh34);
-
-    Alow = _mm_xor_si128(Alow,Amix1);
-    Ahigh = _mm_xor_si128(Ahigh,Amix2);
+    __m128i Alow, Ahigh;
+    mul128by128to256_4by4(A1, A2, A3, A4, B1, B2, B3, B4, &Alow, &Ahigh);
     return lazymod127(Alow, Ahigh);
 }
 
@@ -236,5 +380,170 @@ uint64_t precompReduction64( __m128i A) {
 
 
 
+//////////////////
+// Batched reductions: lazymod127, precompReduction64 and barrettWithoutPrecomputation32
+// applied to 2, 4 or 8 accumulators at once, one accumulator per 128-bit lane of ymm or
+// zmm registers (VPCLMULQDQ). When many short keys are finalized together, this makes
+// the reductions bound by throughput rather than by the latency of each one.
+// The _x2, _x4 and _x8 functions read consecutive accumulators and write the reduced
+// values in the same order; without the wide instructions they reduce one at a time.
+//////////////////
+#if defined(__AVX2__)
+// lazymod127 in each 128-bit lane
+static inline __m256i lazymod127_si256(__m256i Alow, __m256i Ahigh) {
+    const __m256i shift1 = _mm256_or_si256(_mm256_slli_epi64(Ahigh, 1),
+                                           _mm256_bslli_epi128(_mm256_srli_epi64(Ahigh, 63), 8));
+    const __m256i shift2 = _mm256_or_si256(_mm256_slli_epi64(Ahigh, 2),
+                                           _mm256_bslli_epi128(_mm256_srli_epi64(Ahigh, 62), 8));
+    return _mm256_xor_si256(_mm256_xor_si256(Alow, shift1), shift2);
+}
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+static inline __m512i lazymod127_si512(__m512i Alow, __m512i Ahigh) {
+    const __m512i shift1 = _mm512_or_si512(_mm512_slli_epi64(Ahigh, 1),
+                                           _mm512_bslli_epi128(_mm512_srli_epi64(Ahigh, 63), 8));
+    const __m512i shift2 = _mm512_or_si512(_mm512_slli_epi64(Ahigh, 2),
+                                           _mm512_bslli_epi128(_mm512_srli_epi64(Ahigh, 62), 8));
+    return _mm512_xor_si512(_mm512_xor_si512(Alow, shift1), shift2);
+}
+#endif
+
+#if CLMUL_WIDE
+// precompReduction64_si128 in each 128-bit lane (the high 64 bits of each lane contain garbage)
+static inline __m256i precompReduction64_si256(__m256i A) {
+    const __m256i C = _mm256_set1_epi64x((1U<<4)+(1U<<3)+(1U<<1)+(1U<<0));
+    const __m256i table = _mm256_broadcastsi128_si256(
+                              _mm_setr_epi8(0, 27, 54, 45, 108, 119, 90, 65, 216, 195, 238, 245, 180, 175, 130, 153));
+    const __m256i Q2 = _mm256_clmulepi64_epi128(A, C, 0x01);
+    const __m256i Q3 = _mm256_shuffle_epi8(table, _mm256_bsrli_epi128(Q2, 8));
+    return _mm256_xor_si256(Q3, _mm256_xor_si256(Q2, A));
+}
+
+// barrettWithoutPrecomputation32_si128 in each 128-bit lane (only the low 32 bits of each
+// lane are meaningful)
+static inline __m256i barrettWithoutPrecomputation32_si256(__m256i A) {
+    const __m256i C = _mm256_set1_epi64x(1UL+(1UL<<2)+(1UL<<6)+(1UL<<7)+(1UL<<32));
+    const __m256i Q2 = _mm256_clmulepi64_epi128(_mm256_bsrli_epi128(A, 4), C, 0x00);
+    const __m256i Q4 = _mm256_clmulepi64_epi128(_mm256_bsrli_epi128(Q2, 4), C, 0x00);
+    return _mm256_xor_si256(A, Q4);
+}
+
+#if CLMUL_WIDE == 512
+static inline __m512i precompReduction64_si512(__m512i A) {
+    const __m512i C = _mm512_set1_epi64((1U<<4)+(1U<<3)+(1U<<1)+(1U<<0));
+    const __m512i table = _mm512_broadcast_i32x4(
+                              _mm_setr_epi8(0, 27, 54, 45, 108, 119, 90, 65, 216, 195, 238, 245, 180, 175, 130, 153));
+    const __m512i Q2 = _mm512_clmulepi64_epi128(A, C, 0x01);
+    const __m512i Q3 = _mm512_shuffle_epi8(table, _mm512_bsrli_epi128(Q2, 8));
+    return _mm512_xor_si512(Q3, _mm512_xor_si512(Q2, A));
+}
+
+static inline __m512i barrettWithoutPrecomputation32_si512(__m512i A) {
+    const __m512i C = _mm512_set1_epi64(1UL+(1UL<<2)+(1UL<<6)+(1UL<<7)+(1UL<<32));
+    const __m512i Q2 = _mm512_clmulepi64_epi128(_mm512_bsrli_epi128(A, 4), C, 0x00);
+    const __m512i Q4 = _mm512_clmulepi64_epi128(_mm512_bsrli_epi128(Q2, 4), C, 0x00);
+    return _mm512_xor_si512(A, Q4);
+}
+#endif
+#endif
+
+static inline void lazymod127_x2(const __m128i * Alow, const __m128i * Ahigh, __m128i * out) {
+#ifdef __AVX2__
+    _mm256_storeu_si256((__m256i *) out, lazymod127_si256(_mm256_loadu_si256((const __m256i *) Alow),
+                                                          _mm256_loadu_si256((const __m256i *) Ahigh)));
+#else
+    for (int i = 0; i < 2; ++i) out[i] = lazymod127(Alow[i], Ahigh[i]);
+#endif
+}
+
+static inline void lazymod127_x4(const __m128i * Alow, const __m128i * Ahigh, __m128i * out) {
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+    _mm512_storeu_si512((void *) out, lazymod127_si512(_mm512_loadu_si512((const void *) Alow),
+                                                       _mm512_loadu_si512((const void *) Ahigh)));
+#else
+    lazymod127_x2(Alow, Ahigh, out);
+    lazymod127_x2(Alow + 2, Ahigh + 2, out + 2);
+#endif
+}
+
+static inline void lazymod127_x8(const __m128i * Alow, const __m128i * Ahigh, __m128i * out) {
+    lazymod127_x4(Alow, Ahigh, out);
+    lazymod127_x4(Alow + 4, Ahigh + 4, out + 4);
+}
+
+static inline void precompReduction64_x2(const __m128i * A, uint64_t * out) {
+#if CLMUL_WIDE
+    const __m256i r = precompReduction64_si256(_mm256_loadu_si256((const __m256i *) A));
+    _mm_storeu_si128((__m128i *) out, _mm256_castsi256_si128(_mm256_permute4x64_epi64(r, 0x08)));
+#else
+    for (int i = 0; i < 2; ++i) out[i] = precompReduction64(A[i]);
+#endif
+}
+
+static inline void precompReduction64_x4(const __m128i * A, uint64_t * out) {
+#if CLMUL_WIDE == 512
+    const __m512i r = precompReduction64_si512(_mm512_loadu_si512((const void *) A));
+    _mm256_storeu_si256((__m256i *) out,
+                        _mm512_castsi512_si256(_mm512_permutexvar_epi64(_mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7), r)));
+#elif CLMUL_WIDE
+    const __m256i r0 = precompReduction64_si256(_mm256_loadu_si256((const __m256i *) A));
+    const __m256i r1 = precompReduction64_si256(_mm256_loadu_si256((const __m256i *) (A + 2)));
+    _mm256_storeu_si256((__m256i *) out, _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(r0, r1), 0xD8));
+#else
+    for (int i = 0; i < 4; ++i) out[i] = precompReduction64(A[i]);
+#endif
+}
+
+static inline void precompReduction64_x8(const __m128i * A, uint64_t * out) {
+#if CLMUL_WIDE == 512
+    const __m512i r0 = precompReduction64_si512(_mm512_loadu_si512((const void *) A));
+    const __m512i r1 = precompReduction64_si512(_mm512_loadu_si512((const void *) (A + 4)));
+    _mm512_storeu_si512((void *) out,
+                        _mm512_permutex2var_epi64(r0, _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14), r1));
+#else
+    precompReduction64_x4(A, out);
+    precompReduction64_x4(A + 4, out + 4);
+#endif
+}
+
+static inline void barrettWithoutPrecomputation32_x2(const __m128i * A, uint32_t * out) {
+#if CLMUL_WIDE
+    const __m256i r = barrettWithoutPrecomputation32_si256(_mm256_loadu_si256((const __m256i *) A));
+    _mm_storel_epi64((__m128i *) out, _mm256_castsi256_si128(
+                         _mm256_permutevar8x32_epi32(r, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0))));
+#else
+    for (int i = 0; i < 2; ++i) out[i] = barrettWithoutPrecomputation32(A[i]);
+#endif
+}
+
+static inline void barrettWithoutPrecomputation32_x4(const __m128i * A, uint32_t * out) {
+#if CLMUL_WIDE == 512
+    const __m512i r = barrettWithoutPrecomputation32_si512(_mm512_loadu_si512((const void *) A));
+    _mm_storeu_si128((__m128i *) out, _mm512_castsi512_si128(_mm512_permutexvar_epi32(
+                         _mm512_setr_epi32(0, 4, 8, 12, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), r)));
+#elif CLMUL_WIDE
+    const __m256i r0 = barrettWithoutPrecomputation32_si256(_mm256_loadu_si256((const __m256i *) A));
+    const __m256i r1 = barrettWithoutPrecomputation32_si256(_mm256_loadu_si256((const __m256i *) (A + 2)));
+    const __m256i both = _mm256_blend_epi32(r0, _mm256_bslli_epi128(r1, 4), 0x22);
+    _mm_storeu_si128((__m128i *) out, _mm256_castsi256_si128(
+                         _mm256_permutevar8x32_epi32(both, _mm256_setr_epi32(0, 4, 1, 5, 0, 0, 0, 0))));
+#else
+    for (int i = 0; i < 4; ++i) out[i] = barrettWithoutPrecomputation32(A[i]);
+#endif
+}
+
+static inline void barrettWithoutPrecomputation32_x8(const __m128i * A, uint32_t * out) {
+#if CLMUL_WIDE == 512
+    const __m512i r0 = barrettWithoutPrecomputation32_si512(_mm512_loadu_si512((const void *) A));
+    const __m512i r1 = barrettWithoutPrecomputation32_si512(_mm512_loadu_si512((const void *) (A + 4)));
+    const __m512i idx = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 0, 0, 0, 0, 0, 0, 0, 0);
+    _mm256_storeu_si256((__m256i *) out, _mm512_castsi512_si256(_mm512_permutex2var_epi32(r0, idx, r1)));
+#else
+    barrettWithoutPrecomputation32_x4(A, out);
+    barrettWithoutPrecomputation32_x4(A + 4, out + 4);
+#endif
+}
+
 #endif
 #endif
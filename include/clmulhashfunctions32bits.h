@@ -7,6 +7,7 @@
 
 
 #include "clmul.h"
+#include "hashfunctions32bits.h"
 
 
 
@@ -26,16 +27,35 @@ uint32_t hashGaloisFieldMultilinear(const void *  randomsource, const uint32_t *
     return barrettWithoutPrecomputation32(acc);
 }
 
+// hashGaloisFieldMultilinear of the words of a byte string followed by its byte length;
+// randomsource must hold ceil(length / 4) + 2 32-bit words (no alignment is required).
+uint32_t hashGaloisFieldMultilinearBytes(const void *  randomsource, const void *  bytes, const size_t length) {
+    const uint32_t *  randomsource32 = ( const uint32_t * )randomsource;
+    const uint32_t *  string = ( const uint32_t * )bytes;
+    const size_t words = length / 4;
+    uint32_t rest[2];
+    const size_t restlength = __restWords32(bytes, length, rest);
+    __m128i acc = _mm_cvtsi32_si128(*(int * )(randomsource32 + words + restlength));
+    for(size_t i = 0; i < words; ++i) {
+        __m128i temp = _mm_set_epi64x(randomsource32[i],string[i]);
+        __m128i clprod  = _mm_clmulepi64_si128( temp, temp, 0x10);
+        acc = _mm_xor_si128 (clprod,acc);
+    }
+    for(size_t i = 0; i < restlength; ++i) {
+        __m128i temp = _mm_set_epi64x(randomsource32[words + i],rest[i]);
+        __m128i clprod  = _mm_clmulepi64_si128( temp, temp, 0x10);
+        acc = _mm_xor_si128 (clprod,acc);
+    }
+    return barrettWithoutPrecomputation32(acc);
+}
 
-// optimized 32-bit CLMUL hashing
-uint32_t hashGaloisFieldMultilinearHalfMultiplications(const void*  randomsource, const uint32_t *  string, const size_t length) {
+
+// the products of hashGaloisFieldMultilinearHalfMultiplications, xored into acc
+static inline __attribute__((always_inline))
+__m128i __gfHalfMultiplications(__m128i acc, const uint32_t *  randomsource32, const uint32_t *  string, const size_t length) {
     const uint32_t * const endstring = string + length;
-    const uint32_t *  randomsource32 = ( const uint32_t * )randomsource;
-    assert(((uintptr_t) randomsource32 & 15) == 0); // we expect cache line alignment for the keys
-    assert(sizeof(int) == sizeof(uint32_t));
-    __m128i acc = _mm_cvtsi32_si128(*(int * )(randomsource32 + length));
     for(; string +3 < endstring; randomsource32+=4,string+=4 ) {
-        const __m128i temp1 = _mm_load_si128((__m128i * )randomsource32);
+        const __m128i temp1 = _mm_loadu_si128((const __m128i * )randomsource32);
         const __m128i temp2 = _mm_lddqu_si128((__m128i *) string);
         const __m128i twosums = _mm_xor_si128(temp1,temp2);
         const __m128i part1 = _mm_unpacklo_epi32(twosums,_mm_setzero_si128());
@@ -59,6 +79,29 @@ uint32_t hashGaloisFieldMultilinearHalfMultiplications(const void*  randomsource
         __m128i clprod  = _mm_clmulepi64_si128( temp, temp, 0x10);
         acc = _mm_xor_si128 (clprod,acc);
     }
+    return acc;
+}
+
+// optimized 32-bit CLMUL hashing
+uint32_t hashGaloisFieldMultilinearHalfMultiplications(const void*  randomsource, const uint32_t *  string, const size_t length) {
+    const uint32_t *  randomsource32 = ( const uint32_t * )randomsource;
+    assert(((uintptr_t) randomsource32 & 15) == 0); // we expect cache line alignment for the keys
+    assert(sizeof(int) == sizeof(uint32_t));
+    __m128i acc = _mm_cvtsi32_si128(*(int * )(randomsource32 + length));
+    return barrettWithoutPrecomputation32(__gfHalfMultiplications(acc, randomsource32, string, length));
+}
+
+// hashGaloisFieldMultilinearHalfMultiplications of the words of a byte string followed by
+// its byte length and, if needed, a zero word (as for hashMultilinearhalfBytes); randomsource
+// must hold ceil(length / 4) + 3 32-bit words (no alignment is required).
+uint32_t hashGaloisFieldMultilinearHalfMultiplicationsBytes(const void*  randomsource, const void *  bytes, const size_t length) {
+    const uint32_t *  randomsource32 = ( const uint32_t * )randomsource;
+    const size_t pairedwords = length / 4 & ~(size_t) 1;
+    uint32_t rest[4];
+    const size_t restlength = __restPairs32(bytes, length, rest);
+    __m128i acc = _mm_cvtsi32_si128(*(int * )(randomsource32 + pairedwords + restlength));
+    acc = __gfHalfMultiplications(acc, randomsource32, ( const uint32_t * )bytes, pairedwords);
+    acc = __gfHalfMultiplications(acc, randomsource32 + pairedwords, rest, restlength);
     return barrettWithoutPrecomputation32(acc);
 }
 
@@ -5,7 +5,10 @@
 #ifndef CLMULPOLY64BITS_H_
 #define CLMULPOLY64BITS_H_
 
+#include <string.h>
+
 #include "clmul.h"
+#include "avx512diagnostics.h"
 
 
 // given one 8-byte key, generate 128 bytes of powers (randomp, randomp**2, ...) or 2 cache lines.
@@ -34,6 +37,8 @@ void precomputePowers(uint64_t randomp, __m128i * out) {
 
 
 
+AVX512_KERNELS_BEGIN
+
 //CLMULPoly64CL2
 uint64_t CLMULPoly64CL2(const void* rs, const uint64_t * string,
                         const size_t length) {
@@ -64,11 +69,29 @@ uint64_t CLMULPoly64CL2(const void* rs, const uint64_t * string,
         ++string;
     }
     if (string + 15 < endstring) {
+        const __m128i key8 = _mm_load_si128(randomsource + 7);
+#if CLMUL_WIDE == 512
+        // the same sums, four 128-bit lanes per register: the products of the first seven
+        // xored pairs, and of the last 128 bits by key8 in the last lane
+        const __m512i K0 = _mm512_loadu_si512((const void *) randomsource);
+        const __m512i K1 = _mm512_loadu_si512((const void *) (randomsource + 4));
+        for (; string + 15 < endstring; string += 16) {
+            const __m512i X0 = _mm512_loadu_si512((const void *) string);
+            const __m512i X1 = _mm512_loadu_si512((const void *) (string + 8));
+            const __m512i A0 = _mm512_xor_si512(X0, K0);
+            const __m512i A1 = _mm512_mask_xor_epi64(X1, 0x3F, X1, K1);
+            const __m512i B1 = _mm512_mask_mov_epi64(A1, 0xC0, K1);
+            __m512i P = _mm512_xor_si512(_mm512_clmulepi64_epi128(A0, A0, 0x01),
+                                         _mm512_clmulepi64_epi128(A1, B1, 0x01));
+            P = _mm512_xor_si512(P, _mm512_maskz_mov_epi64(0xC0, _mm512_bslli_epi128(X1, 8)));
+            const __m128i R1 = _mm_xor_si128(clmul_fold256(clmul_fold512(P)),
+                                             _mm_clmulepi64_si128(acc, key8, 0x00));
+            acc = precompReduction64_si128(R1);
+        }
+#else
         const __m128i key5 = _mm_load_si128(randomsource + 4);
         const __m128i key6 = _mm_load_si128(randomsource + 5);
         const __m128i key7 = _mm_load_si128(randomsource + 6);
-        const __m128i key8 = _mm_load_si128(randomsource + 7);
-
         for (; string + 15 < endstring; string += 16) {
             __m128i p1 = _mm_clmulepi64_si128(acc, key8, 0x00);
 
@@ -116,6 +139,7 @@ uint64_t CLMULPoly64CL2(const void* rs, const uint64_t * string,
             R1 = _mm_xor_si128(R1, Q5);
             acc = precompReduction64_si128(R1);
         }
+#endif
     }
     if (string + 7 < endstring) {
         __m128i p1 = _mm_clmulepi64_si128(acc, key4, 0x00);
@@ -175,6 +199,382 @@ uint64_t CLMULPoly64CL2(const void* rs, const uint64_t * string,
     return _mm_cvtsi128_si64(acc);
 }
 
+AVX512_KERNELS_END
+
+
+//////////////////
+// CLMULPoly64 with prepared keys: the plain polynomial hash
+//     m_1 p**n + m_2 p**(n-1) + ... + m_n p
+// over GF(2^64) with the reduction of precompReduction64. The string is processed in
+// blocks of up to depth words. Each word of a block is multiplied by its own power of p,
+// and 8 products per iteration go to independent accumulators (the lanes of a zmm
+// register, or xmm/ymm accumulators), so the only dependency chain is one multiplication
+// and one reduction per block rather than one CLMUL latency per word.
+//////////////////
+
+#define CLMULPOLY64_MAX_DEPTH 64
+
+// depth used by the CLMULPoly64x8 adapter
+#ifndef CLMULPOLY64_DEFAULT_DEPTH
+#define CLMULPOLY64_DEFAULT_DEPTH 64
+#endif
+
+// The powers of one 64-bit key, from the highest down: powers[k] = p**(depth - k), so the
+// r words of a block use powers + depth - r onward. depth is 16, 32 or 64 (any multiple of 8
+// up to CLMULPOLY64_MAX_DEPTH works).
+typedef struct {
+    uint64_t powers[CLMULPOLY64_MAX_DEPTH] __attribute__ ((aligned (64)));
+    uint64_t randomp;
+    int depth;
+} clmulpoly64_key_t;
+
+void clmulpoly64_prepare_key(clmulpoly64_key_t * key, uint64_t randomp, int depth) {
+    assert((depth >= 8) && (depth <= CLMULPOLY64_MAX_DEPTH) && (depth % 8 == 0));
+    const __m128i p = _mm_cvtsi64_si128((long long) randomp);
+    __m128i power = p;
+    key->randomp = randomp;
+    key->depth = depth;
+    key->powers[depth - 1] = randomp;
+    for (int k = depth - 2; k >= 0; --k) {
+        power = precompReduction64_si128(_mm_clmulepi64_si128(power, p, 0x00));
+        key->powers[k] = (uint64_t) _mm_cvtsi128_si64(power);
+    }
+}
+
+// (acc + string[0]) p**r + string[1] p**(r-1) + ... + string[r-1] p before the reduction,
+// where powers points to p**r, p**(r-1), ..., p
+static inline __m128i __clmulpoly64_block(const uint64_t * powers, __m128i acc,
+        const uint64_t * string, const size_t r) {
+    __m128i sum = _mm_clmulepi64_si128(acc, _mm_loadl_epi64((const __m128i *) powers), 0x00);
+    size_t j = 0;
+#if CLMUL_WIDE
+    __m256i sum256 = _mm256_setzero_si256();
+#if CLMUL_WIDE == 512
+    __m512i lo512 = _mm512_setzero_si512(), hi512 = _mm512_setzero_si512();
+    for (; j + 8 <= r; j += 8) {
+        const __m512i X = _mm512_loadu_si512((const void *) (string + j));
+        const __m512i K = _mm512_loadu_si512((const void *) (powers + j));
+        lo512 = _mm512_xor_si512(lo512, _mm512_clmulepi64_epi128(X, K, 0x00));
+        hi512 = _mm512_xor_si512(hi512, _mm512_clmulepi64_epi128(X, K, 0x11));
+    }
+    sum256 = clmul_fold512(_mm512_xor_si512(lo512, hi512));
+#endif
+    for (; j + 4 <= r; j += 4) {
+        const __m256i X = _mm256_loadu_si256((const __m256i *) (string + j));
+        const __m256i K = _mm256_loadu_si256((const __m256i *) (powers + j));
+        sum256 = _mm256_xor_si256(sum256, _mm256_xor_si256(_mm256_clmulepi64_epi128(X, K, 0x00),
+                                  _mm256_clmulepi64_epi128(X, K, 0x11)));
+    }
+    sum = _mm_xor_si128(sum, clmul_fold256(sum256));
+#else
+    __m128i s1 = _mm_setzero_si128(), s2 = _mm_setzero_si128(), s3 = _mm_setzero_si128();
+    for (; j + 8 <= r; j += 8) {
+        const __m128i X0 = _mm_loadu_si128((const __m128i *) (string + j));
+        const __m128i X1 = _mm_loadu_si128((const __m128i *) (string + j + 2));
+        const __m128i X2 = _mm_loadu_si128((const __m128i *) (string + j + 4));
+        const __m128i X3 = _mm_loadu_si128((const __m128i *) (string + j + 6));
+        const __m128i K0 = _mm_loadu_si128((const __m128i *) (powers + j));
+        const __m128i K1 = _mm_loadu_si128((const __m128i *) (powers + j + 2));
+        const __m128i K2 = _mm_loadu_si128((const __m128i *) (powers + j + 4));
+        const __m128i K3 = _mm_loadu_si128((const __m128i *) (powers + j + 6));
+        sum = _mm_xor_si128(sum, _mm_xor_si128(_mm_clmulepi64_si128(X0, K0, 0x00),
+                                               _mm_clmulepi64_si128(X0, K0, 0x11)));
+        s1 = _mm_xor_si128(s1, _mm_xor_si128(_mm_clmulepi64_si128(X1, K1, 0x00),
+                                             _mm_clmulepi64_si128(X1, K1, 0x11)));
+        s2 = _mm_xor_si128(s2, _mm_xor_si128(_mm_clmulepi64_si128(X2, K2, 0x00),
+                                             _mm_clmulepi64_si128(X2, K2, 0x11)));
+        s3 = _mm_xor_si128(s3, _mm_xor_si128(_mm_clmulepi64_si128(X3, K3, 0x00),
+                                             _mm_clmulepi64_si128(X3, K3, 0x11)));
+    }
+    sum = _mm_xor_si128(_mm_xor_si128(sum, s1), _mm_xor_si128(s2, s3));
+#endif
+    for (; j + 2 <= r; j += 2) {
+        const __m128i X = _mm_loadu_si128((const __m128i *) (string + j));
+        const __m128i K = _mm_loadu_si128((const __m128i *) (powers + j));
+        sum = _mm_xor_si128(sum, _mm_xor_si128(_mm_clmulepi64_si128(X, K, 0x00),
+                                               _mm_clmulepi64_si128(X, K, 0x11)));
+    }
+    if (j < r)
+        sum = _mm_xor_si128(sum, _mm_clmulepi64_si128(_mm_loadl_epi64((const __m128i *) (string + j)),
+                                                      _mm_loadl_epi64((const __m128i *) (powers + j)), 0x00));
+    return sum;
+}
+
+uint64_t clmulpoly64_hash(const clmulpoly64_key_t * key, const uint64_t * string, const size_t length) {
+    const size_t depth = (size_t) key->depth;
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + depth <= length; i += depth)
+        acc = precompReduction64_si128(__clmulpoly64_block(key->powers, acc, string + i, depth));
+    if (i < length) {
+        const size_t r = length - i;
+        acc = precompReduction64_si128(__clmulpoly64_block(key->powers + depth - r, acc, string + i, r));
+    }
+    return (uint64_t) _mm_cvtsi128_si64(acc);
+}
+
+// Returns the calling thread's prepared key for the 64-bit key at rs, preparing it when the
+// key or the depth changed since the last call.
+const clmulpoly64_key_t * clmulpoly64_thread_key(const void * rs, int depth) {
+    static __thread clmulpoly64_key_t cached; // depth 0 until the first call
+    uint64_t randomp;
+    memcpy(&randomp, rs, sizeof(randomp));
+    if ((cached.depth != depth) || (cached.randomp != randomp))
+        clmulpoly64_prepare_key(&cached, randomp, depth);
+    return &cached;
+}
+
+// hashFunction64 adapter; rs should point to one 64-bit key
+uint64_t CLMULPoly64x8(const void* rs, const uint64_t * string, const size_t length) {
+    return clmulpoly64_hash(clmulpoly64_thread_key(rs, CLMULPOLY64_DEFAULT_DEPTH), string, length);
+}
+
+
+//////////////////
+// Concatenation: since clmulpoly64_hash is a plain polynomial in p,
+//     hash(A||B) = hash(A) p**|B| + hash(B)
+// so hashes of pieces hashed separately (say, in parallel) can be combined, and the hash
+// of a long sequence of pieces can be updated when one piece changes without rehashing
+// the others (clmulpoly64_rope_t below). CLMULPoly64CL2 multiplies pairs of words
+// together, so it is not a polynomial in p and has no such combination.
+//////////////////
+
+// a b over GF(2^64)
+static inline uint64_t clmulpoly64_multiply(uint64_t a, uint64_t b) {
+    return precompReduction64(_mm_clmulepi64_si128(_mm_cvtsi64_si128((long long) a),
+                              _mm_cvtsi64_si128((long long) b), 0x00));
+}
+
+// p**e by squaring, fully reduced (p**0 is 1)
+uint64_t clmulpoly64_power(uint64_t randomp, uint64_t e) {
+    __m128i result = _mm_cvtsi64_si128(1);
+    __m128i base = _mm_cvtsi64_si128((long long) randomp);
+    while (e != 0) {
+        if (e & 1)
+            result = precompReduction64_si128(_mm_clmulepi64_si128(result, base, 0x00));
+        e >>= 1;
+        if (e != 0)
+            base = precompReduction64_si128(_mm_clmulepi64_si128(base, base, 0x00));
+    }
+    return (uint64_t) _mm_cvtsi128_si64(result);
+}
+
+// p**length, from the key's table when length is at most its depth
+static inline uint64_t __clmulpoly64_length_power(const clmulpoly64_key_t * key, uint64_t length) {
+    if (length == 0)
+        return 1;
+    if (length <= (uint64_t) key->depth)
+        return key->powers[key->depth - length];
+    return clmulpoly64_power(key->randomp, length);
+}
+
+// hash(A||B) from hA = hash(A) and hB = hash(B), where B has lenB words
+uint64_t clmulpoly_combine(uint64_t hA, uint64_t hB, uint64_t lenB, const clmulpoly64_key_t * key) {
+    return hB ^ clmulpoly64_multiply(hA, __clmulpoly64_length_power(key, lenB));
+}
+
+typedef struct {
+    uint64_t hash;
+    uint64_t length; // in words
+    uint64_t power; // p**length
+} clmulpoly64_span_t;
+
+// A sequence of pieces (a rope) as a segment tree: the leaves hold the hash and length of
+// each piece, every inner node the combination of its two children, and the root the hash
+// of the whole concatenation. Each node also keeps p**length, so combining two children
+// takes two multiplications and no exponentiation. Replacing a piece recombines only its
+// ancestors, so it costs O(log pieces) however long the other pieces are. Unset pieces
+// are empty.
+typedef struct {
+    const clmulpoly64_key_t * key; // not owned, must outlive the rope
+    size_t leaves; // a power of two, at least the number of pieces
+    clmulpoly64_span_t * nodes; // nodes[1] is the root, nodes[leaves + i] is piece i
+} clmulpoly64_rope_t;
+
+// returns 0 on success, -1 if the nodes cannot be allocated
+int clmulpoly64_rope_init(clmulpoly64_rope_t * rope, const clmulpoly64_key_t * key, size_t pieces) {
+    size_t leaves = 1;
+    while (leaves < pieces)
+        leaves <<= 1;
+    rope->key = key;
+    rope->leaves = leaves;
+    rope->nodes = (clmulpoly64_span_t *) malloc(2 * leaves * sizeof(clmulpoly64_span_t));
+    if (rope->nodes == NULL)
+        return -1;
+    for (size_t node = 0; node < 2 * leaves; ++node) {
+        rope->nodes[node].hash = 0;
+        rope->nodes[node].length = 0;
+        rope->nodes[node].power = 1;
+    }
+    return 0;
+}
+
+void clmulpoly64_rope_free(clmulpoly64_rope_t * rope) {
+    free(rope->nodes);
+    rope->nodes = NULL;
+}
+
+// sets piece i from a hash computed elsewhere (with the rope's key) and its length in words
+void clmulpoly64_rope_set_hash(clmulpoly64_rope_t * rope, size_t i, uint64_t hash, uint64_t length) {
+    assert(i < rope->leaves);
+    size_t node = rope->leaves + i;
+    rope->nodes[node].hash = hash;
+    rope->nodes[node].length = length;
+    rope->nodes[node].power = __clmulpoly64_length_power(rope->key, length);
+    for (node >>= 1; node >= 1; node >>= 1) {
+        const clmulpoly64_span_t left = rope->nodes[2 * node];
+        const clmulpoly64_span_t right = rope->nodes[2 * node + 1];
+        rope->nodes[node].hash = right.hash ^ clmulpoly64_multiply(left.hash, right.power);
+        rope->nodes[node].length = left.length + right.length;
+        rope->nodes[node].power = clmulpoly64_multiply(left.power, right.power);
+    }
+}
+
+void clmulpoly64_rope_set(clmulpoly64_rope_t * rope, size_t i, const uint64_t * string, const size_t length) {
+    clmulpoly64_rope_set_hash(rope, i, clmulpoly64_hash(rope->key, string, length), length);
+}
+
+// clmulpoly64_hash of the concatenation of all pieces
+uint64_t clmulpoly64_rope_hash(const clmulpoly64_rope_t * rope) {
+    return rope->nodes[1].hash;
+}
+
+
+//////////////////
+// Prefix-hash index: with H(k) = clmulpoly64_hash of the first k words of a buffer,
+//     hash of the words [i, j) = H(j) + H(i) p**(j - i)
+// so once the H(k) are known any substring hashes in O(1). The index keeps H(k) at every
+// position (stride 1) or at every block of key->depth words (stride depth, where the rest
+// of a block is hashed on demand, at most depth - 1 words with the 8-way block kernel),
+// and p**(q depth) for each block q, so that p**(j - i) is one product with the key's
+// table. Its storage is a flat array of clmulpoly64_prefix_index_words words owned by the
+// caller: it can live in a file mapped next to a mapped buffer and be reattached later.
+//////////////////
+
+typedef struct {
+    const clmulpoly64_key_t * key; // not owned
+    const uint64_t * string; // not owned, not modified
+    size_t length; // in words
+    size_t stride; // 1 or key->depth
+    const uint64_t * prefix; // prefix[k] = H(k stride), k = 0 .. length / stride
+    const uint64_t * giant; // giant[q] = p**(q depth), q = 0 .. length / depth
+} clmulpoly64_prefix_index_t;
+
+size_t clmulpoly64_prefix_index_words(size_t length, size_t stride, int depth) {
+    return (length / stride + 1) + (length / (size_t) depth + 1);
+}
+
+// uses storage (clmulpoly64_prefix_index_words words) as already built for this key,
+// string and stride
+void clmulpoly64_prefix_index_attach(clmulpoly64_prefix_index_t * index, const clmulpoly64_key_t * key,
+                                     const uint64_t * string, size_t length, size_t stride,
+                                     const uint64_t * storage) {
+    assert((stride == 1) || (stride == (size_t) key->depth));
+    index->key = key;
+    index->string = string;
+    index->length = length;
+    index->stride = stride;
+    index->prefix = storage;
+    index->giant = storage + length / stride + 1;
+}
+
+// H(k) for k = start + 1 .. start + count, one product and reduction per word, from H(start)
+static inline __m128i __clmulpoly64_prefix_chain(__m128i acc, const __m128i p, const uint64_t * string,
+        uint64_t * prefix, size_t start, size_t count) {
+    for (size_t k = start; k < start + count; ++k) {
+        acc = precompReduction64_si128(_mm_clmulepi64_si128(
+                                           _mm_xor_si128(acc, _mm_loadl_epi64((const __m128i *) (string + k))), p, 0x00));
+        _mm_storel_epi64((__m128i *) (prefix + k + 1), acc);
+    }
+    return acc;
+}
+
+// Computes the index into storage (clmulpoly64_prefix_index_words words) and attaches it.
+// With stride depth this is one pass of the block kernel of clmulpoly64_hash. With stride 1
+// every position needs its own reduction, so the buffer is cut into 8 segments: their
+// starting values come from the block kernel, then the 8 chains of one product and one
+// reduction per word are interleaved, which hides the latency of each.
+void clmulpoly64_prefix_index_build(clmulpoly64_prefix_index_t * index, const clmulpoly64_key_t * key,
+                                    const uint64_t * string, size_t length, size_t stride,
+                                    uint64_t * storage) {
+    clmulpoly64_prefix_index_attach(index, key, string, length, stride, storage);
+    const size_t depth = (size_t) key->depth;
+    uint64_t * prefix = storage;
+    uint64_t * giant = storage + length / stride + 1;
+    giant[0] = 1;
+    for (size_t q = 1; q <= length / depth; ++q)
+        giant[q] = clmulpoly64_multiply(giant[q - 1], key->powers[0]);
+    prefix[0] = 0;
+    if (stride != 1) {
+        __m128i acc = _mm_setzero_si128();
+        for (size_t k = 0; k + depth <= length; k += depth) {
+            acc = precompReduction64_si128(__clmulpoly64_block(key->powers, acc, string + k, depth));
+            prefix[k / depth + 1] = (uint64_t) _mm_cvtsi128_si64(acc);
+        }
+        return;
+    }
+    const __m128i p = _mm_cvtsi64_si128((long long) key->randomp);
+    if (length < 1024) { // a single chain
+        __clmulpoly64_prefix_chain(_mm_setzero_si128(), p, string, prefix, 0, length);
+        return;
+    }
+    // The chains move together for steps words; segment l starts at l (steps + 9) so that the
+    // 16 streams of loads and stores do not fall on the same offset modulo 4 kB, and each
+    // chain then finishes its segment alone (the last one takes the rest of the buffer).
+    const size_t steps = length / 8 - 64, segment = steps + 9;
+    const uint64_t segmentpower = clmulpoly64_power(key->randomp, segment);
+    uint64_t start[8];
+    start[0] = 0;
+    for (int l = 1; l < 8; ++l)
+        start[l] = clmulpoly64_hash(key, string + (l - 1) * segment, segment)
+                   ^ clmulpoly64_multiply(start[l - 1], segmentpower);
+    __m128i a0 = _mm_cvtsi64_si128((long long) start[0]), a1 = _mm_cvtsi64_si128((long long) start[1]);
+    __m128i a2 = _mm_cvtsi64_si128((long long) start[2]), a3 = _mm_cvtsi64_si128((long long) start[3]);
+    __m128i a4 = _mm_cvtsi64_si128((long long) start[4]), a5 = _mm_cvtsi64_si128((long long) start[5]);
+    __m128i a6 = _mm_cvtsi64_si128((long long) start[6]), a7 = _mm_cvtsi64_si128((long long) start[7]);
+    for (size_t k = 0; k < steps; ++k) {
+        a0 = __clmulpoly64_prefix_chain(a0, p, string, prefix, k, 1);
+        a1 = __clmulpoly64_prefix_chain(a1, p, string, prefix, segment + k, 1);
+        a2 = __clmulpoly64_prefix_chain(a2, p, string, prefix, 2 * segment + k, 1);
+        a3 = __clmulpoly64_prefix_chain(a3, p, string, prefix, 3 * segment + k, 1);
+        a4 = __clmulpoly64_prefix_chain(a4, p, string, prefix, 4 * segment + k, 1);
+        a5 = __clmulpoly64_prefix_chain(a5, p, string, prefix, 5 * segment + k, 1);
+        a6 = __clmulpoly64_prefix_chain(a6, p, string, prefix, 6 * segment + k, 1);
+        a7 = __clmulpoly64_prefix_chain(a7, p, string, prefix, 7 * segment + k, 1);
+    }
+    __clmulpoly64_prefix_chain(a0, p, string, prefix, steps, 9);
+    __clmulpoly64_prefix_chain(a1, p, string, prefix, segment + steps, 9);
+    __clmulpoly64_prefix_chain(a2, p, string, prefix, 2 * segment + steps, 9);
+    __clmulpoly64_prefix_chain(a3, p, string, prefix, 3 * segment + steps, 9);
+    __clmulpoly64_prefix_chain(a4, p, string, prefix, 4 * segment + steps, 9);
+    __clmulpoly64_prefix_chain(a5, p, string, prefix, 5 * segment + steps, 9);
+    __clmulpoly64_prefix_chain(a6, p, string, prefix, 6 * segment + steps, 9);
+    __clmulpoly64_prefix_chain(a7, p, string, prefix, 7 * segment + steps, length - 7 * segment - steps);
+}
+
+// H(k)
+static inline uint64_t __clmulpoly64_index_prefix(const clmulpoly64_prefix_index_t * index, size_t k) {
+    const size_t stride = index->stride;
+    const size_t block = k / stride, r = k % stride;
+    if (r == 0)
+        return index->prefix[block];
+    const clmulpoly64_key_t * key = index->key;
+    return precompReduction64(__clmulpoly64_block(key->powers + key->depth - r,
+                              _mm_cvtsi64_si128((long long) index->prefix[block]),
+                              index->string + block * stride, r));
+}
+
+// clmulpoly64_hash of the words [i, j) of the indexed string
+uint64_t clmulpoly64_substring_hash(const clmulpoly64_prefix_index_t * index, size_t i, size_t j) {
+    assert((i <= j) && (j <= index->length));
+    const size_t depth = (size_t) index->key->depth;
+    const size_t q = (j - i) / depth, r = (j - i) % depth;
+    const uint64_t power = (r == 0) ? index->giant[q]
+                           : clmulpoly64_multiply(index->giant[q], index->key->powers[depth - r]);
+    return __clmulpoly64_index_prefix(index, j)
+           ^ clmulpoly64_multiply(__clmulpoly64_index_prefix(index, i), power);
+}
+
 
 #endif /* CLMULPOLY64BITS_H_ */
 
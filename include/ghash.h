@@ -7,6 +7,8 @@
 #define GHASH_H_
 
 #include "clmul.h"
+#include "avx512diagnostics.h"
+#include <string.h>
 
 // Gueron and Kounavis fig. 5
 __m128i gfmul_fig5(__m128i a, __m128i b) {
@@ -172,6 +174,205 @@ __m128i GHASH_m128(__m128i key, const uint64_t * string64,
 }
 
 
+// (hi:lo) <<= 1 as one 256-bit value: the product of bit-reflected operands is off by one bit
+static inline void gfshl1_256(__m128i * lo, __m128i * hi) {
+    const __m128i clo = _mm_srli_epi64(*lo, 63);
+    const __m128i chi = _mm_srli_epi64(*hi, 63);
+    *hi = _mm_or_si128(_mm_slli_epi64(*hi, 1), _mm_slli_si128(chi, 8));
+    *hi = _mm_or_si128(*hi, _mm_srli_si128(clo, 8));
+    *lo = _mm_or_si128(_mm_slli_epi64(*lo, 1), _mm_slli_si128(clo, 8));
+}
+
+// Reduces the (already shifted) 256-bit (hi:lo) modulo x^128+x^7+x^2+x+1 with two carry-less
+// multiplications instead of the shifts of fig. 5 and fig. 8; the remainder is the same.
+static inline __m128i gfreduce_clmul(__m128i lo, __m128i hi) {
+    const __m128i poly = _mm_set_epi64x(0xc200000000000000ULL, 1);
+    __m128i t = _mm_clmulepi64_si128(lo, poly, 0x10);
+    lo = _mm_xor_si128(_mm_shuffle_epi32(lo, 78), t);
+    t = _mm_clmulepi64_si128(lo, poly, 0x10);
+    lo = _mm_xor_si128(_mm_shuffle_epi32(lo, 78), t);
+    return _mm_xor_si128(lo, hi);
+}
+
+// H^8, H^7, ..., H^1: powers[j] multiplies block j of a group of eight
+void ghash_precompute_powers8(__m128i key, __m128i * powers) {
+    powers[7] = key;
+    for (int j = 6; j >= 0; --j)
+        powers[j] = gfmul_fig5(powers[j + 1], key);
+}
+
+AVX512_KERNELS_BEGIN
+
+// The aggregated kernels below serve GHASH (bit-reflected operands, so every product is
+// shifted left by one before the reduction) and POLYVAL (RFC 8452), whose dot product
+// a * b * x^-128 is the same reduction without the shift. reflected is a compile-time
+// constant at every call.
+
+// sum of powers[8 - k + j] * blocks[j] for j < k, with a single reduction
+static inline __m128i ghash_aggregate(const __m128i * powers, const __m128i * blocks, size_t k,
+                                      const int reflected) {
+    __m128i lo, hi;
+    mul128by128to256_sum(powers + 8 - k, blocks, k, &lo, &hi);
+    if (reflected) gfshl1_256(&lo, &hi);
+    return gfreduce_clmul(lo, hi);
+}
+
+#if CLMUL_WIDE
+#define GHASH_8WAY_VPCLMUL CLMUL_WIDE
+
+// The running hash is the only serial dependency between groups of eight blocks, so the
+// SIMD loops multiply it apart from the blocks, by Hs = H^8 << 1: this takes the one-bit
+// shift off the dependency chain (Htop is all ones when the shift carried a bit out).
+static inline void ghash_mul_shifted(__m128i Hs, __m128i Htop, __m128i a, __m128i * lo, __m128i * hi) {
+    mul128by128to256_clmul(Hs, a, lo, hi);
+    *hi = _mm_xor_si128(*hi, _mm_and_si128(Htop, a));
+}
+#endif
+
+// Horner steps over howmany groups of eight blocks, starting from answer
+static inline __m128i ghash_groups8(const __m128i * powers, __m128i answer, const __m128i * string,
+                                    size_t howmany, const int reflected) {
+#ifdef GHASH_8WAY_VPCLMUL
+    __m128i Hs = powers[0], Htop = _mm_setzero_si128();
+    if (reflected) {
+        gfshl1_256(&Hs, &Htop);
+        Htop = _mm_cmpgt_epi32(_mm_shuffle_epi32(Htop, 0), _mm_setzero_si128());
+    }
+    for (; howmany > 0; --howmany, string += 8) {
+        __m128i lo128, hi128;
+        mul128by128to256_sum(powers, string, 8, &lo128, &hi128);
+        if (reflected) gfshl1_256(&lo128, &hi128);
+        __m128i alo, ahi;
+        ghash_mul_shifted(Hs, Htop, answer, &alo, &ahi);
+        answer = gfreduce_clmul(_mm_xor_si128(lo128, alo), _mm_xor_si128(hi128, ahi));
+    }
+#else
+    for (; howmany > 0; --howmany, string += 8) {
+        __m128i blocks[8];
+        for (int j = 0; j < 8; ++j) blocks[j] = _mm_loadu_si128(string + j);
+        blocks[0] = _mm_xor_si128(blocks[0], answer);
+        answer = ghash_aggregate(powers, blocks, 8, reflected);
+    }
+#endif
+    return answer;
+}
+
+// the last k < 8 blocks of a string, with one aggregated reduction
+static inline __m128i ghash_tail(const __m128i * powers, __m128i answer, __m128i * blocks, size_t k,
+                                 const int reflected) {
+    if (k == 0) return answer;
+    blocks[0] = _mm_xor_si128(blocks[0], answer);
+    return ghash_aggregate(powers, blocks, k, reflected);
+}
+
+static inline __m128i ghash_8way(const __m128i * powers, const uint64_t * string64,
+                                 const size_t length, const int reflected) {
+    const size_t lengthm128 = length / 2;
+    const __m128i * string = (const __m128i *) string64;
+    __m128i answer = ghash_groups8(powers, _mm_setzero_si128(), string, lengthm128 / 8, reflected);
+    // at most seven blocks and a half remain
+    __m128i blocks[8];
+    size_t k = 0;
+    for (size_t i = lengthm128 / 8 * 8; i < lengthm128; ++i) blocks[k++] = _mm_loadu_si128(string + i);
+    if (length & 1) blocks[k++] = _mm_loadl_epi64(string + lengthm128);
+    return ghash_tail(powers, answer, blocks, k, reflected);
+}
+
+// GHASH_m128 with eight blocks (128 bytes) aggregated per reduction instead of four.
+// powers comes from ghash_precompute_powers8 and can be reused across strings; the
+// result is the same as GHASH_m128 with that key.
+__m128i GHASH_m128_8way(const __m128i * powers, const uint64_t * string64,
+                        const size_t length) {
+    return ghash_8way(powers, string64, length, 1);
+}
+
+// POLYVAL's dot product a * b * x^-128 (RFC 8452): no bit reflection to undo
+static inline __m128i polyval_dot(__m128i a, __m128i b) {
+    __m128i lo, hi;
+    mul128by128to256_clmul(a, b, &lo, &hi);
+    return gfreduce_clmul(lo, hi);
+}
+
+// H^8, H^7, ..., H^1 for POLYVAL, powers taken with polyval_dot
+void polyval_precompute_powers8(__m128i key, __m128i * powers) {
+    powers[7] = key;
+    for (int j = 6; j >= 0; --j)
+        powers[j] = polyval_dot(powers[j + 1], key);
+}
+
+// POLYVAL (RFC 8452) of a string of 64-bit words, a trailing odd word padded with zeros;
+// powers comes from polyval_precompute_powers8.
+__m128i POLYVAL_m128(const __m128i * powers, const uint64_t * string64,
+                     const size_t length) {
+    return ghash_8way(powers, string64, length, 0);
+}
+
+/*
+ * Incremental GHASH or POLYVAL over byte strings delivered in any number of pieces.
+ * The final partial block is padded with zeros, so a string of 64-bit words gives the
+ * same value as GHASH_m128_8way (or POLYVAL_m128) over those words; like GHASH_m128,
+ * no length block is appended. The power table belongs to the caller: compute it once
+ * per key and share it between streams and threads (it is only read).
+ */
+typedef struct {
+    const __m128i * powers; // from ghash_precompute_powers8 or polyval_precompute_powers8
+    __m128i answer;
+    __m128i buffer[8]; // a partial group of eight blocks
+    size_t buffered; // in bytes, less than sizeof(buffer)
+    int reflected; // 1 for GHASH, 0 for POLYVAL
+} ghash_stream_t;
+
+void ghash_stream_init(ghash_stream_t * stream, const __m128i * powers) {
+    stream->powers = powers;
+    stream->answer = _mm_setzero_si128();
+    stream->buffered = 0;
+    stream->reflected = 1;
+}
+
+void polyval_stream_init(ghash_stream_t * stream, const __m128i * powers) {
+    ghash_stream_init(stream, powers);
+    stream->reflected = 0;
+}
+
+static inline __m128i ghash_stream_groups8(const ghash_stream_t * stream, const __m128i * string,
+                                           size_t howmany) {
+    if (stream->reflected)
+        return ghash_groups8(stream->powers, stream->answer, string, howmany, 1);
+    return ghash_groups8(stream->powers, stream->answer, string, howmany, 0);
+}
+
+void ghash_stream_update(ghash_stream_t * stream, const void * data, size_t length) {
+    const char * in = (const char *) data;
+    if (stream->buffered > 0) {
+        size_t room = sizeof(stream->buffer) - stream->buffered;
+        size_t n = length < room ? length : room;
+        memcpy((char *) stream->buffer + stream->buffered, in, n);
+        stream->buffered += n;
+        in += n;
+        length -= n;
+        if (stream->buffered < sizeof(stream->buffer)) return;
+        stream->answer = ghash_stream_groups8(stream, stream->buffer, 1);
+        stream->buffered = 0;
+    }
+    size_t howmany = length / sizeof(stream->buffer);
+    if (howmany > 0) {
+        stream->answer = ghash_stream_groups8(stream, (const __m128i *) in, howmany);
+        in += howmany * sizeof(stream->buffer);
+        length -= howmany * sizeof(stream->buffer);
+    }
+    memcpy(stream->buffer, in, length);
+    stream->buffered = length;
+}
+
+// the stream can be reused after ghash_stream_init (or polyval_stream_init)
+__m128i ghash_stream_final(ghash_stream_t * stream) {
+    const size_t k = (stream->buffered + 15) / 16;
+    memset((char *) stream->buffer + stream->buffered, 0, k * 16 - stream->buffered);
+    if (stream->reflected)
+        return ghash_tail(stream->powers, stream->answer, stream->buffer, k, 1);
+    return ghash_tail(stream->powers, stream->answer, stream->buffer, k, 0);
+}
+
 // for testing purposes, we need a 64-bit version of GHASH so we
 // compute the full 128-bit version and then we just keep the least significant bits
 // rs should point to 128 random bits.
@@ -181,4 +382,53 @@ uint64_t GHASH64bit(const void* rs, const uint64_t * string,
     __m128i answer = GHASH_m128(key, string, length);
     return _mm_cvtsi128_si64(answer);
 }
+
+// A power table with the key it was computed for
+typedef struct {
+    __m128i powers[8];
+    unsigned char key[16];
+    int ready;
+} ghash_powers_cache_t;
+
+// Returns the power table of the 128-bit key at rs, recomputing it (with precompute, which
+// is ghash_precompute_powers8 or polyval_precompute_powers8) only when the key differs
+// from the one cached.
+static inline const __m128i * ghash_cached_powers(ghash_powers_cache_t * cache, const void * rs,
+                                                  void (*precompute)(__m128i, __m128i *)) {
+    if (!cache->ready || (memcmp(cache->key, rs, sizeof(cache->key)) != 0)) {
+        memcpy(cache->key, rs, sizeof(cache->key));
+        precompute(_mm_loadu_si128((const __m128i*) rs ), cache->powers);
+        cache->ready = 1;
+    }
+    return cache->powers;
+}
+
+// The calling thread's GHASH (or POLYVAL) power table for the 128-bit key at rs, computed
+// when the key changed since the last call
+const __m128i * ghash_thread_powers(const void * rs) {
+    static __thread ghash_powers_cache_t cached;
+    return ghash_cached_powers(&cached, rs, ghash_precompute_powers8);
+}
+
+const __m128i * polyval_thread_powers(const void * rs) {
+    static __thread ghash_powers_cache_t cached;
+    return ghash_cached_powers(&cached, rs, polyval_precompute_powers8);
+}
+
+// GHASH64bit through GHASH_m128_8way (same values); rs should point to 128 random bits.
+uint64_t GHASH64bit8way(const void* rs, const uint64_t * string,
+                        const size_t length) {
+    __m128i answer = GHASH_m128_8way(ghash_thread_powers(rs), string, length);
+    return _mm_cvtsi128_si64(answer);
+}
+
+// POLYVAL truncated to 64 bits; rs should point to 128 random bits.
+uint64_t POLYVAL64bit(const void* rs, const uint64_t * string,
+                      const size_t length) {
+    __m128i answer = POLYVAL_m128(polyval_thread_powers(rs), string, length);
+    return _mm_cvtsi128_si64(answer);
+}
+
+AVX512_KERNELS_END
+
 #endif /* GHASH_H_ */
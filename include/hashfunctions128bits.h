@@ -0,0 +1,50 @@
+
+
+#ifndef HASHFUNCTIONS128BIT_H_
+#define HASHFUNCTIONS128BIT_H_
+
+#include <x86intrin.h>
+
+// first pointer is a random source,
+// next pointer is the data.
+// outputs a 128-bit hash value (low 64 bits in the first lane)
+typedef __m128i (*hashFunction128)(const void *  ,const  uint64_t * , const size_t );
+
+
+#include "City/City.h"
+
+// Google hash function, 128-bit output; rs should point to 128 random bits (the seed)
+__m128i hashCity128(const void*  rs, const uint64_t *  string, const size_t length) {
+    const uint64_t * seed = (const uint64_t *) rs;
+    uint128 answer = CityHash128WithSeed((const char *) string, length * sizeof(uint64_t),
+                                         (uint128){seed[0], seed[1]});
+    return _mm_set_epi64x(Uint128High64(answer), Uint128Low64(answer));
+}
+
+#if defined(__SSE4_2__) && defined(__x86_64__)
+// CityHashCrc128 switches to the CRC32-based CityHashCrc256 above 900 bytes
+__m128i hashCityCrc128(const void*  rs, const uint64_t *  string, const size_t length) {
+    const uint64_t * seed = (const uint64_t *) rs;
+    uint128 answer = CityHashCrc128WithSeed((const char *) string, length * sizeof(uint64_t),
+                                            (uint128){seed[0], seed[1]});
+    return _mm_set_epi64x(Uint128High64(answer), Uint128Low64(answer));
+}
+#endif // __SSE4_2__
+
+#ifdef __PCLMUL__
+#include "ghash.h"
+
+// GHASH without truncation (almost universal over GF(2^128)); rs should point to 128 random bits.
+__m128i GHASH128bit(const void* rs, const uint64_t * string,
+                    const size_t length) {
+    __m128i key = _mm_loadu_si128((const __m128i*) rs );
+    return GHASH_m128(key, string, length);
+}
+
+__m128i GHASH128bit8way(const void* rs, const uint64_t * string,
+                        const size_t length) {
+    return GHASH_m128_8way(ghash_thread_powers(rs), string, length);
+}
+#endif // __PCLMUL__
+
+#endif /* HASHFUNCTIONS128BIT_H_ */
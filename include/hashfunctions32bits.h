@@ -2,12 +2,52 @@
 #define HASHFUNCTIONS32BITS_H_
 
 #include <immintrin.h>
+#include <string.h>
+#include "avx512diagnostics.h"
 
 // first pointer is a random source,
 // next pointer is the data.
 // outputs a hash value
 typedef uint32_t (*hashFunction)(const void *  ,const  uint32_t * , const size_t );
 
+// The *Bytes variants hash byte strings in place (the length is then in bytes): the
+// string is read as little-endian words, the last 1 to 3 bytes as one more word padded
+// with zeros, and the byte length is hashed as a final word so that padding cannot collide.
+typedef uint32_t (*hashFunctionBytes)(const void *  ,const  void * , const size_t );
+
+// the last count (1 to 3) bytes as a word padded with zeros, without reading past them
+static inline uint32_t __tailWord32(const void * bytes, const size_t count) {
+    const uint8_t * p = (const uint8_t *) bytes;
+    uint32_t word = p[0];
+    if (count > 1) word |= (uint32_t) p[1] << 8;
+    if (count > 2) word |= (uint32_t) p[2] << 16;
+    return word;
+}
+
+// the words that follow the whole words of a byte string: the padded last bytes, if
+// any, then the byte length; rest must have room for 2 words, the count is returned
+static inline size_t __restWords32(const void * bytes, const size_t length, uint32_t * rest) {
+    size_t count = 0;
+    if (length & 3)
+        rest[count++] = __tailWord32((const uint8_t *) bytes + (length & ~(size_t) 3), length & 3);
+    rest[count++] = (uint32_t) length;
+    return count;
+}
+
+// the same for functions over pairs of words, starting at the last even word boundary:
+// the odd whole word if any, the words above, and a zero word to make the count even;
+// rest must have room for 4 words
+static inline size_t __restPairs32(const void * bytes, const size_t length, uint32_t * rest) {
+    const size_t words = length / 4;
+    size_t count = 0;
+    if (words & 1)
+        memcpy(rest + count++, (const uint32_t *) bytes + words - 1, sizeof(uint32_t));
+    count += __restWords32(bytes, length, rest + count);
+    if (count & 1)
+        rest[count++] = 0;
+    return count;
+}
+
 //
 // this is strongly universal. Condition: randomsource must be at least as long as
 // the string length  + 3.
@@ -82,18 +122,166 @@ uint32_t hashMultilineardouble(const void *  rs, const uint32_t *  string, const
 
 
 
+AVX512_KERNELS_BEGIN
+
+// hashMultilinear with AVX2 (AVX-512 when available): the same value, and so strongly
+// universal as well. The multilinear sum is computed modulo 2^64 in any order, so this
+// also gives the values of hashMultilinear2by2 and hashMultilineardouble (even lengths).
+// A 64-bit random word times a 32-bit word modulo 2^64 is built from the products of the
+// word with the low and with the high half of the random word (_mm*_mul_epu32).
+static inline __attribute__((always_inline))
+uint64_t __multilinearSum(const uint64_t *  randomsource, const uint32_t *  string, const size_t length) {
+    uint64_t sum = 0;
+    size_t i = 0;
+#ifdef __AVX512F__
+    __m512i acclo512 = _mm512_setzero_si512(), acchi512 = _mm512_setzero_si512();
+    for (; i + 8 <= length; i += 8) {
+        const __m512i k = _mm512_loadu_si512((const void *)(randomsource + i));
+        const __m512i x = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(string + i)));
+        acclo512 = _mm512_add_epi64(acclo512, _mm512_mul_epu32(k, x));
+        acchi512 = _mm512_add_epi64(acchi512, _mm512_mul_epu32(_mm512_srli_epi64(k, 32), x));
+    }
+    sum += (uint64_t) _mm512_reduce_add_epi64(_mm512_add_epi64(acclo512, _mm512_slli_epi64(acchi512, 32)));
+#endif
+    __m256i acclo = _mm256_setzero_si256(), acchi = _mm256_setzero_si256();
+    for (; i + 4 <= length; i += 4) {
+        const __m256i k = _mm256_loadu_si256((const __m256i *)(randomsource + i));
+        const __m256i x = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(string + i)));
+        acclo = _mm256_add_epi64(acclo, _mm256_mul_epu32(k, x));
+        acchi = _mm256_add_epi64(acchi, _mm256_mul_epu32(_mm256_srli_epi64(k, 32), x));
+    }
+    const __m256i acc = _mm256_add_epi64(acclo, _mm256_slli_epi64(acchi, 32));
+    const __m128i acc128 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum += (uint64_t) _mm_cvtsi128_si64(acc128) + (uint64_t) _mm_extract_epi64(acc128, 1);
+    for (; i < length; ++i)
+        sum += randomsource[i] * (uint64_t) string[i];
+    return sum;
+}
+
+uint32_t hashMultilinearavx(const void *  rs, const uint32_t *  string, const size_t length) {
+    const uint64_t *  randomsource = (const uint64_t *) rs;
+    uint64_t sum = *(randomsource++);
+    sum += __multilinearSum(randomsource, string, length);
+    sum += randomsource[length];
+    return (int) (sum>>32);
+}
+
+// hashMultilinear (and hashMultilinearavx) of the words of a byte string followed by its
+// byte length; randomsource must hold ceil(length / 4) + 3 64-bit words.
+uint32_t hashMultilinearBytes(const void *  rs, const void *  bytes, const size_t length) {
+    const uint64_t *  randomsource = (const uint64_t *) rs;
+    const size_t words = length / 4;
+    uint32_t rest[2];
+    const size_t restlength = __restWords32(bytes, length, rest);
+    uint64_t sum = *(randomsource++);
+    sum += __multilinearSum(randomsource, (const uint32_t *) bytes, words);
+    randomsource += words;
+    for (size_t i = 0; i < restlength; ++i)
+        sum += randomsource[i] * (uint64_t) rest[i];
+    sum += randomsource[restlength];
+    return (int) (sum>>32);
+}
+
+// hashMultilinearhalf with AVX2 (AVX-512 when available), giving the same values. Each
+// pair of words makes two 64-bit sums whose product modulo 2^64 takes three _mm*_mul_epu32:
+// low*low, plus the two cross products shifted up by 32 bits.
+static inline __attribute__((always_inline))
+uint64_t __multilinearhalfSum(const uint64_t *  randomsource, const uint32_t *  string, const size_t length) {
+    uint64_t sum = 0;
+    size_t i = 0;
+#ifdef __AVX512F__
+    __m512i acc512 = _mm512_setzero_si512();
+    for (; i + 16 <= length; i += 16) {
+        // even random words and string words in a, the odd ones in b
+        const __m512i k0 = _mm512_loadu_si512((const void *)(randomsource + i));
+        const __m512i k1 = _mm512_loadu_si512((const void *)(randomsource + i + 8));
+        const __m512i x0 = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(string + i)));
+        const __m512i x1 = _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)(string + i + 8)));
+        const __m512i a = _mm512_add_epi64(_mm512_unpacklo_epi64(k0, k1), _mm512_unpacklo_epi64(x0, x1));
+        const __m512i b = _mm512_add_epi64(_mm512_unpackhi_epi64(k0, k1), _mm512_unpackhi_epi64(x0, x1));
+        const __m512i cross = _mm512_add_epi64(_mm512_mul_epu32(a, _mm512_srli_epi64(b, 32)),
+                                               _mm512_mul_epu32(_mm512_srli_epi64(a, 32), b));
+        acc512 = _mm512_add_epi64(acc512, _mm512_mul_epu32(a, b));
+        acc512 = _mm512_add_epi64(acc512, _mm512_slli_epi64(cross, 32));
+    }
+    sum += (uint64_t) _mm512_reduce_add_epi64(acc512);
+#endif
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 8 <= length; i += 8) {
+        const __m256i k0 = _mm256_loadu_si256((const __m256i *)(randomsource + i));
+        const __m256i k1 = _mm256_loadu_si256((const __m256i *)(randomsource + i + 4));
+        const __m256i x0 = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(string + i)));
+        const __m256i x1 = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(string + i + 4)));
+        const __m256i a = _mm256_add_epi64(_mm256_unpacklo_epi64(k0, k1), _mm256_unpacklo_epi64(x0, x1));
+        const __m256i b = _mm256_add_epi64(_mm256_unpackhi_epi64(k0, k1), _mm256_unpackhi_epi64(x0, x1));
+        const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)),
+                                               _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epu32(a, b));
+        acc = _mm256_add_epi64(acc, _mm256_slli_epi64(cross, 32));
+    }
+    const __m128i acc128 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum += (uint64_t) _mm_cvtsi128_si64(acc128) + (uint64_t) _mm_extract_epi64(acc128, 1);
+    for (; i < length; i += 2)
+        sum += (randomsource[i] + (uint64_t) string[i]) * (randomsource[i + 1] + (uint64_t) string[i + 1]);
+    return sum;
+}
+
+uint32_t hashMultilinearhalfavx(const void *  rs, const uint32_t *  string, const size_t length) {
+    assert ( length / 2 * 2 == length );// length is even
+    const uint64_t *  randomsource = (const uint64_t *) rs;
+    uint64_t sum = *(randomsource++);
+    sum += __multilinearhalfSum(randomsource, string, length);
+    sum += randomsource[length];
+    return (int) (sum>>32);
+}
+
+// hashMultilinearhalf (and hashMultilinearhalfavx) of the words of a byte string followed
+// by its byte length and, if needed, a zero word; randomsource must hold ceil(length / 4) + 4
+// 64-bit words.
+uint32_t hashMultilinearhalfBytes(const void *  rs, const void *  bytes, const size_t length) {
+    const uint64_t *  randomsource = (const uint64_t *) rs;
+    const size_t pairedwords = length / 4 & ~(size_t) 1;
+    uint32_t rest[4];
+    const size_t restlength = __restPairs32(bytes, length, rest);
+    uint64_t sum = *(randomsource++);
+    sum += __multilinearhalfSum(randomsource, (const uint32_t *) bytes, pairedwords);
+    randomsource += pairedwords;
+    for (size_t i = 0; i < restlength; i += 2)
+        sum += (randomsource[i] + (uint64_t) rest[i]) * (randomsource[i + 1] + (uint64_t) rest[i + 1]);
+    sum += randomsource[restlength];
+    return (int) (sum>>32);
+}
+
+AVX512_KERNELS_END
+
+
 //Black, J.; Halevi, S.; Krawczyk, H.; Krovetz, T. (1999). "UMAC: Fast and Secure Message Authentication". Advances in Cryptology (CRYPTO '99)., Equation 1
 // just high bits
-uint32_t hashNH(const void *  randomsource, const uint32_t *  string, const size_t length) {
-    assert ( length / 2 * 2 == length );// length is pair
+static inline uint64_t __nhSum(const uint32_t *  randomsource32, const uint32_t *  string, const size_t length) {
     const uint32_t * const endstring = string + length;
     uint64_t sum = 0;
-    const uint32_t *  randomsource32 = ( const uint32_t * )randomsource;
     for(; string!= endstring; randomsource32+=2,string+=2 ) {
         sum+=
             (uint64_t) ( *randomsource32+ *string) *
             (*(randomsource32 + 1) + *(string+1));
     }
+    return sum;
+}
+
+uint32_t hashNH(const void *  randomsource, const uint32_t *  string, const size_t length) {
+    assert ( length / 2 * 2 == length );// length is pair
+    return __nhSum(( const uint32_t * )randomsource, string, length)>>32;
+}
+
+// hashNH of the words of a byte string followed by its byte length and, if needed, a zero
+// word; randomsource must hold ceil(length / 4) + 2 32-bit words.
+uint32_t hashNHBytes(const void *  randomsource, const void *  bytes, const size_t length) {
+    const uint32_t *  randomsource32 = ( const uint32_t * )randomsource;
+    const size_t pairedwords = length / 4 & ~(size_t) 1;
+    uint32_t rest[4];
+    const size_t restlength = __restPairs32(bytes, length, rest);
+    const uint64_t sum = __nhSum(randomsource32, (const uint32_t *) bytes, pairedwords)
+                         + __nhSum(randomsource32 + pairedwords, rest, restlength);
     return sum>>32;
 }
 
@@ -173,69 +361,226 @@ uint32_t hashFNV1(const void * useless,const uint32_t *  string, const size_t le
 
 
 
-// used by pyramidal_Multilinear below
-// code not thoroughly checked
-void __hashMulti(const void *  randomsource, const uint32_t *  string, uint32_t *  output, int length, int blocksize) {
-    int bufferpos = 0;
-    int offset = length - length/blocksize*blocksize;
-    for(; bufferpos<length/blocksize; ++bufferpos) {
-        output[bufferpos] = hashMultilinear(randomsource, string+bufferpos*blocksize, blocksize);
+#define PYRAMIDAL_BLOCKSIZE 256
+// hashMultilinear on a block reads its length + 2 random words
+#define PYRAMIDAL_RANDOM_WORDS_PER_LEVEL (PYRAMIDAL_BLOCKSIZE + 2)
+// 256^8 = 2^64, so no size_t length needs more levels
+#define PYRAMIDAL_MAX_LEVELS 8
+
+// used by pyramidal_Multilinear below: hashMultilinear on nblocks (at most 4) strings of
+// length words each, stride words apart, all with the same random words
+static inline void __hashMultiBlocks(const void *  randomsource, const uint32_t *  string, size_t stride,
+                                     size_t length, const int nblocks, uint32_t *  output) {
+#ifdef __AVX2__
+    // the 64-bit by 32-bit products are formed from two 32x32-bit ones (low and high key
+    // halves), exactly as the scalar code does modulo 2^64; each random word is loaded
+    // once for all the blocks
+    const uint64_t * keys = (const uint64_t *) randomsource;
+    __m256i acclo[4], acchi[4];
+    for (int b = 0; b < nblocks; ++b) {
+        acclo[b] = _mm256_setzero_si256();
+        acchi[b] = _mm256_setzero_si256();
+    }
+    const size_t vectorized = length & ~(size_t) 3;
+    for (size_t i = 0; i < vectorized; i += 4) {
+        const __m256i k = _mm256_loadu_si256((const __m256i *)(keys + 1 + i));
+        const __m256i khi = _mm256_srli_epi64(k, 32);
+        for (int b = 0; b < nblocks; ++b) {
+            const __m256i x = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(string + b * stride + i)));
+            acclo[b] = _mm256_add_epi64(acclo[b], _mm256_mul_epu32(k, x));
+            acchi[b] = _mm256_add_epi64(acchi[b], _mm256_mul_epu32(khi, x));
+        }
     }
-    if(offset>0) {
-        output[length/blocksize] = hashMultilinear(randomsource, string+length/blocksize*blocksize,
-                                   offset);
+    for (int b = 0; b < nblocks; ++b) {
+        __m256i acc = _mm256_add_epi64(acclo[b], _mm256_slli_epi64(acchi[b], 32));
+        __m128i acc128 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        uint64_t sum = keys[0] + (uint64_t) _mm_cvtsi128_si64(acc128) + (uint64_t) _mm_extract_epi64(acc128, 1);
+        for (size_t j = 0; j < (length & 3); ++j)
+            sum += keys[1 + vectorized + j] * (uint64_t) string[b * stride + vectorized + j];
+        sum += keys[1 + length];
+        output[b] = (uint32_t) (sum >> 32);
     }
+#else
+    for (int b = 0; b < nblocks; ++b)
+        output[b] = hashMultilinear(randomsource, string + b * stride, length);
+#endif
+}
+
+// words of scratch space pyramidal_Multilinear_with_buffer needs for a string of
+// length words: one block for each level above the first (log_256(length) levels)
+size_t pyramidal_Multilinear_buffer_size(size_t length) {
+    size_t levels = 0;
+    for (; length > PYRAMIDAL_BLOCKSIZE; length = (length + PYRAMIDAL_BLOCKSIZE - 1) / PYRAMIDAL_BLOCKSIZE)
+        ++levels;
+    return levels * PYRAMIDAL_BLOCKSIZE;
 }
 
+// used by pyramidal_Multilinear_with_buffer: adds value to a level of the pyramid and
+// hashes full blocks upwards; a value reaching the top level is the answer
+static inline void __pyramidPush(const uint64_t *  keys, uint32_t *  buffer, size_t *  filled,
+                                 int levels, int level, uint32_t value, uint32_t *  answer) {
+    for (; level < levels; ++level) {
+        uint32_t * words = buffer + (level - 1) * PYRAMIDAL_BLOCKSIZE;
+        words[filled[level]++] = value;
+        if (filled[level] < PYRAMIDAL_BLOCKSIZE) return;
+        __hashMultiBlocks(keys + level * PYRAMIDAL_RANDOM_WORDS_PER_LEVEL, words, 0,
+                          PYRAMIDAL_BLOCKSIZE, 1, &value);
+        filled[level] = 0;
+    }
+    *answer = value;
+}
 
 // this function is 4/2**32 almost universal on 32 bits
-// it uses at most 8KB of random bits (for strings having 32-bit lengths)
-// code not thoroughly checked
-uint32_t pyramidal_Multilinear(const void *  randomsource, const uint32_t *  string, const size_t len) {
-    size_t length = len;
-    int blocksize = 256;
-    int newlength = ((length+blocksize-1)/blocksize);
-    uint32_t * array = (uint32_t *)  malloc(newlength * sizeof(uint32_t));
-    __hashMulti(randomsource, string, array,  length, blocksize);
-    const char * randomChars = (const char *)randomsource;
-    randomChars+=blocksize+1;
-    length = newlength;
-    while(length>1) {
-        newlength = ((length+blocksize-1)/blocksize);
-        uint32_t * array2 = (uint32_t *) malloc(newlength * sizeof(uint32_t));
-        __hashMulti(randomChars, array, array2,  length, blocksize);
-        randomChars+=blocksize+1;
-        free(array);
-        array = array2;
-        length = newlength;
-        if(length == 1) {
-        }
+// level l of the pyramid hashes blocks of 256 words with hashMultilinear and random words
+// [258 l, 258 l + 258) of randomsource, so strings having 32-bit lengths (at most 4 levels)
+// use 8256 bytes of random bits
+// The levels are filled as the string is read: a level holds a partial block in buffer
+// (see pyramidal_Multilinear_buffer_size) and hashes it up when it is full, so no
+// intermediate array as long as the string is ever needed.
+uint32_t pyramidal_Multilinear_with_buffer(const void *  randomsource, const uint32_t *  string, const size_t len,
+                                           uint32_t *  buffer) {
+    const uint64_t * keys = (const uint64_t *) randomsource;
+    // levels: how many times the words are hashed before one remains
+    int levels = 1;
+    for (size_t n = len; n > PYRAMIDAL_BLOCKSIZE; n = (n + PYRAMIDAL_BLOCKSIZE - 1) / PYRAMIDAL_BLOCKSIZE)
+        ++levels;
+    size_t filled[PYRAMIDAL_MAX_LEVELS] = {0};
+    uint32_t answer = 0;
+    uint32_t hashes[4];
+    const size_t fullblocks = len / PYRAMIDAL_BLOCKSIZE;
+    const size_t remainder = len - fullblocks * PYRAMIDAL_BLOCKSIZE;
+    size_t block = 0;
+    for (; block + 4 <= fullblocks; block += 4) {
+        __hashMultiBlocks(keys, string + block * PYRAMIDAL_BLOCKSIZE, PYRAMIDAL_BLOCKSIZE,
+                          PYRAMIDAL_BLOCKSIZE, 4, hashes);
+        for (int h = 0; h < 4; ++h)
+            __pyramidPush(keys, buffer, filled, levels, 1, hashes[h], &answer);
+    }
+    for (; block < fullblocks; ++block) {
+        __hashMultiBlocks(keys, string + block * PYRAMIDAL_BLOCKSIZE, 0, PYRAMIDAL_BLOCKSIZE, 1, hashes);
+        __pyramidPush(keys, buffer, filled, levels, 1, hashes[0], &answer);
+    }
+    if (remainder > 0 || len == 0) { // the last, partial block (or the empty string)
+        __hashMultiBlocks(keys, string + block * PYRAMIDAL_BLOCKSIZE, 0, remainder, 1, hashes);
+        __pyramidPush(keys, buffer, filled, levels, 1, hashes[0], &answer);
+    }
+    // partial blocks left at the upper levels, from the bottom up
+    for (int level = 1; level < levels; ++level) {
+        if (filled[level] == 0) continue;
+        __hashMultiBlocks(keys + level * PYRAMIDAL_RANDOM_WORDS_PER_LEVEL, buffer + (level - 1) * PYRAMIDAL_BLOCKSIZE,
+                          0, filled[level], 1, hashes);
+        filled[level] = 0;
+        __pyramidPush(keys, buffer, filled, levels, level + 1, hashes[0], &answer);
     }
-    uint32_t answer = array[0];
-    free(array);
     return answer;
 }
 
+// pyramidal_Multilinear_with_buffer with its scratch space on the stack (at most 7KB)
+uint32_t pyramidal_Multilinear(const void *  randomsource, const uint32_t *  string, const size_t len) {
+    uint32_t buffer[(PYRAMIDAL_MAX_LEVELS - 1) * PYRAMIDAL_BLOCKSIZE];
+    return pyramidal_Multilinear_with_buffer(randomsource, string, len, buffer);
+}
+
+AVX512_KERNELS_BEGIN
+
 // Almost-strongly universal pseudo dot product (aka NH, aka half multilinear) using AVX
-// and AVX2 instructions.
-uint32_t pdp32avx(const void *rs, const uint32_t *string, const size_t length) {
-  const uint32_t *const endstring = string + length;
+// and AVX2 instructions (16 words per step with AVX-512).
+// Any length is accepted: the last words are padded with zeros to a multiple of 8, so
+// the random source (which need not be aligned) must hold 32 * (ceil(length / 8) + 1) + 48 bytes.
+// The string is made of words whole words then tailbytes (0 to 3) bytes, and length is the
+// value hashed in the final step.
+static inline __attribute__((always_inline))
+uint32_t __pdp32avx(const void *rs, const uint32_t *string, const size_t words,
+                    const size_t tailbytes, const uint64_t length) {
+  const uint32_t *const endstring = string + words;
   const __m256i *randomsource = (const __m256i *)rs;
-  assert(((uintptr_t)randomsource & 31) == 0);
-  assert ((length & 7) == 0);
-  __m256i acc = *randomsource;
+  __m256i acc = _mm256_loadu_si256(randomsource);
   ++randomsource;
+#ifdef __AVX512F__
+  // each 512-bit step uses the same random words as two 256-bit steps, so the value does
+  // not depend on the instruction set
+  __m512i acc512 = _mm512_zextsi256_si512(acc);
+  for (; string + 15 < endstring; randomsource += 2, string += 16) {
+    __m512i input = _mm512_loadu_si512((const void *)string);
+    input = _mm512_add_epi32(input, _mm512_loadu_si512((const void *)randomsource));
+    __m512i hi = _mm512_srli_epi64(input, 32);
+    input = _mm512_mul_epu32(input, hi);
+    acc512 = _mm512_add_epi64(acc512, input);
+  }
+  acc = _mm256_add_epi64(_mm512_castsi512_si256(acc512), _mm512_extracti64x4_epi64(acc512, 1));
+#endif
   for (; string + 7 < endstring; randomsource += 1, string += 8) {
     __m256i input = _mm256_loadu_si256((const __m256i *)string);
-    input = _mm256_add_epi32(input, *randomsource);
+    input = _mm256_add_epi32(input, _mm256_loadu_si256(randomsource));
+    __m256i hi = _mm256_srli_epi64(input, 32);
+    input = _mm256_mul_epu32(input, hi);
+    acc = _mm256_add_epi64(acc, input);
+  }
+  if (string < endstring || tailbytes) {
+    // masked load of the last 0 to 7 words: nothing past the end of the string is read
+    const int left = (int)(endstring - string);
+#if defined(__AVX512F__) && defined(__AVX512VL__)
+    __m256i input = _mm256_maskz_loadu_epi32((__mmask8)((1u << left) - 1), string);
+    if (tailbytes)
+      input = _mm256_mask_set1_epi32(input, (__mmask8)(1u << left), (int)__tailWord32(endstring, tailbytes));
+#else
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(left), lanes);
+    __m256i input = _mm256_maskload_epi32((const int *)string, mask);
+    if (tailbytes)
+      input = _mm256_blendv_epi8(input, _mm256_set1_epi32((int)__tailWord32(endstring, tailbytes)),
+                                 _mm256_cmpeq_epi32(_mm256_set1_epi32(left), lanes));
+#endif
+    input = _mm256_add_epi32(input, _mm256_loadu_si256(randomsource));
     __m256i hi = _mm256_srli_epi64(input, 32);
     input = _mm256_mul_epu32(input, hi);
     acc = _mm256_add_epi64(acc, input);
+    ++randomsource;
   }
-  const int64_t intermediate[2] = {(int64_t)length, _mm256_extract_epi64(acc, 0) +
-          _mm256_extract_epi64(acc, 1) + _mm256_extract_epi64(acc, 2) +
-          _mm256_extract_epi64(acc, 3)};
-  return hashMultilinear(randomsource, (const uint32_t *)intermediate, 4);
+  const __m128i acc128 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  const uint64_t sum = (uint64_t)_mm_cvtsi128_si64(acc128) + (uint64_t)_mm_extract_epi64(acc128, 1);
+  // hashMultilinear of the words of (length, sum), computed in place
+  const uint64_t *keys = (const uint64_t *)randomsource;
+  uint64_t answer = keys[0] + keys[1] * (uint32_t)length + keys[2] * (uint32_t)((uint64_t)length >> 32)
+                    + keys[3] * (uint32_t)sum + keys[4] * (uint32_t)(sum >> 32) + keys[5];
+  return (uint32_t)(answer >> 32);
+}
+
+uint32_t pdp32avx(const void *rs, const uint32_t *string, const size_t length) {
+  return __pdp32avx(rs, string, length, 0, length);
+}
+
+// pdp32avx of the words of a byte string, with the byte length in place of the word count
+// in the final step; the random source must hold 32 * (ceil(length / 32) + 1) + 48 bytes.
+uint32_t pdp32avxBytes(const void *rs, const void *bytes, const size_t length) {
+  return __pdp32avx(rs, (const uint32_t *)bytes, length / 4, length & 3, length);
+}
+
+AVX512_KERNELS_END
+
+#include "PMP/PMP_C_wrapper.h"
+
+// PMP+-Multilinear over 32-bit words (ignores seed, but good to benchmark running speed)
+// Reference: Dmytro Ivanchykhin, Sergey Ignatchenko, Daniel Lemire, Regular and almost universal hashing: an efficient implementation
+// https://arxiv.org/abs/1609.09840
+uint32_t hashPMP32(const void*  rs, const uint32_t *  string, const size_t length) {
+    (void) rs;
+    return pmp32_hash((const unsigned char *) string, length * sizeof(uint32_t));
+}
+
+// same family as hashPMP32, computed with 64-bit arithmetic (ignores seed)
+uint32_t hashPMP64out32(const void*  rs, const uint32_t *  string, const size_t length) {
+    (void) rs;
+    return pmp64out32_hash((const unsigned char *) string, length * sizeof(uint32_t));
+}
+
+#include "SipHash/halfsiphash.h"
+
+// HalfSipHash-2-4 (SipHash on 32-bit words, 32-bit output)
+uint32_t hashHalfSipHash(const void*  rs, const uint32_t *  string, const size_t length) {
+    uint32_t answer;
+    halfsiphash((uint8_t * ) &answer, (const uint8_t * )string, length * sizeof(uint32_t), (const uint8_t *)rs, 4 );
+    return answer;
 }
 
 #endif /* HASHFUNCTIONS32BITS_H_ */
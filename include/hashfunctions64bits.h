@@ -17,6 +17,152 @@ uint64_t hashPMP64(const void*  rs, const uint64_t *  string, const size_t lengt
     return pmp64_hash((const unsigned char *) string, length * sizeof(uint64_t));
 }
 
+// 32-bit output PMP hash functions on strings of 64-bit words, so that they can be
+// compared with the 64-bit hash functions (ignore seed)
+uint64_t hashPMP32_64(const void*  rs, const uint64_t *  string, const size_t length) {
+    (void) rs;
+    return pmp32_hash((const unsigned char *) string, length * sizeof(uint64_t));
+}
+
+uint64_t hashPMP64out32_64(const void*  rs, const uint64_t *  string, const size_t length) {
+    (void) rs;
+    return pmp64out32_hash((const unsigned char *) string, length * sizeof(uint64_t));
+}
+
+
+#include <immintrin.h>
+#include "avx512diagnostics.h"
+
+//
+// 64-bit analogue of hashMultilinear (hashfunctions32bits.h): with 128-bit random keys
+// m_0, m_1, ..., the hash of the 64-bit words s_1, ..., s_n is the top 64 bits of
+// m_0 + m_1 s_1 + ... + m_n s_n + m_{n+1} modulo 2^128. This is strongly universal.
+// Key m_i is randomsource[2i] + 2^64 randomsource[2i+1], so randomsource must hold
+// 2 * (length + 2) 64-bit words.
+//
+// Reference: Owen Kaser and Daniel Lemire, Strongly universal string hashing is fast, Computer Journal
+// http://arxiv.org/abs/1202.4961
+
+// m * word modulo 2^128: the full product of the low key word (mulx) and the low 64 bits
+// of the high key word times the word
+static inline __attribute__((always_inline))
+unsigned __int128 __multilinear64Product(const uint64_t * key, const uint64_t word) {
+#ifdef __BMI2__
+    unsigned long long hi;
+    const uint64_t lo = _mulx_u64(key[0], word, &hi);
+#else
+    const unsigned __int128 full = (unsigned __int128) key[0] * word;
+    const uint64_t lo = (uint64_t) full, hi = (uint64_t) (full >> 64);
+#endif
+    return ((unsigned __int128) (hi + key[1] * word) << 64) | lo;
+}
+
+// two sums for the even and the odd words, so that their add/adc chains overlap
+static inline __attribute__((always_inline))
+unsigned __int128 __multilinear64Scalar(const uint64_t * randomsource, const uint64_t * string,
+                                        const size_t length) {
+    unsigned __int128 even = 0, odd = 0;
+    size_t i = 0;
+    for (; i + 2 <= length; i += 2) {
+        even += __multilinear64Product(randomsource + 2 * i, string[i]);
+        odd += __multilinear64Product(randomsource + 2 * i + 2, string[i + 1]);
+    }
+    if (i < length)
+        even += __multilinear64Product(randomsource + 2 * i, string[i]);
+    return even + odd;
+}
+
+static inline __attribute__((always_inline))
+unsigned __int128 __multilinear64Key(const uint64_t * randomsource) {
+    return ((unsigned __int128) randomsource[1] << 64) | randomsource[0];
+}
+
+uint64_t hashMultilinear64(const void *  rs, const uint64_t *  string, const size_t length) {
+    const uint64_t *  randomsource = (const uint64_t *) rs;
+    unsigned __int128 sum = __multilinear64Key(randomsource);
+    sum += __multilinear64Scalar(randomsource + 2, string, length);
+    sum += __multilinear64Key(randomsource + 2 * (length + 1));
+    return (uint64_t) (sum >> 64);
+}
+
+AVX512_KERNELS_BEGIN
+
+#ifdef __AVX512F__
+// Eight words per iteration with 32x32->64 multiplies. The low key words need the full
+// product: with a = a0 + 2^32 a1 and s = s0 + 2^32 s1, a s = a0 s0 + 2^32 (a1 s0 + a0 s1)
+// + 2^64 a1 s1. Each of the first two columns is kept as its sum modulo 2^64 and the sum
+// of the high halves of its products, which is exact below 2^31 iterations and gives back
+// the low halves. The high key words only need their product modulo 2^64.
+static inline __attribute__((always_inline))
+unsigned __int128 __multilinear64Sum512(const uint64_t * randomsource, const uint64_t * string,
+                                        const size_t length) {
+    const __m512i even = _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i odd = _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1);
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i s0 = zero, h0 = zero, s1 = zero, h1 = zero, s2 = zero, t0 = zero, t1 = zero;
+    for (size_t i = 0; i + 8 <= length; i += 8) {
+        const __m512i k0 = _mm512_loadu_si512((const void *)(randomsource + 2 * i));
+        const __m512i k1 = _mm512_loadu_si512((const void *)(randomsource + 2 * i + 8));
+        const __m512i a = _mm512_permutex2var_epi64(k0, even, k1);
+        const __m512i b = _mm512_permutex2var_epi64(k0, odd, k1);
+        const __m512i x = _mm512_loadu_si512((const void *)(string + i));
+        const __m512i x1 = _mm512_srli_epi64(x, 32);
+        const __m512i a1 = _mm512_srli_epi64(a, 32);
+        const __m512i p00 = _mm512_mul_epu32(a, x);
+        const __m512i p10 = _mm512_mul_epu32(a1, x);
+        const __m512i p01 = _mm512_mul_epu32(a, x1);
+        s0 = _mm512_add_epi64(s0, p00);
+        h0 = _mm512_add_epi64(h0, _mm512_srli_epi64(p00, 32));
+        s1 = _mm512_add_epi64(s1, _mm512_add_epi64(p10, p01));
+        h1 = _mm512_add_epi64(h1, _mm512_add_epi64(_mm512_srli_epi64(p10, 32), _mm512_srli_epi64(p01, 32)));
+        s2 = _mm512_add_epi64(s2, _mm512_mul_epu32(a1, x1));
+        t0 = _mm512_add_epi64(t0, _mm512_mul_epu32(b, x));
+        t1 = _mm512_add_epi64(t1, _mm512_add_epi64(_mm512_mul_epu32(_mm512_srli_epi64(b, 32), x),
+                                                   _mm512_mul_epu32(b, x1)));
+    }
+    uint64_t S0[8], H0[8], S1[8], H1[8], S2[8], T0[8], T1[8];
+    _mm512_storeu_si512((void *) S0, s0);
+    _mm512_storeu_si512((void *) H0, h0);
+    _mm512_storeu_si512((void *) S1, s1);
+    _mm512_storeu_si512((void *) H1, h1);
+    _mm512_storeu_si512((void *) S2, s2);
+    _mm512_storeu_si512((void *) T0, t0);
+    _mm512_storeu_si512((void *) T1, t1);
+    unsigned __int128 total = 0;
+    for (int j = 0; j < 8; ++j) {
+        const uint64_t low0 = S0[j] - (H0[j] << 32);
+        const uint64_t low1 = S1[j] - (H1[j] << 32);
+        total += low0;
+        total += ((unsigned __int128) H0[j] + low1) << 32;
+        total += (unsigned __int128) (H1[j] + S2[j] + T0[j] + (T1[j] << 32)) << 64;
+    }
+    return total;
+}
+#endif
+
+// hashMultilinear64 with AVX-512 when available, giving the same values
+uint64_t hashMultilinear64avx(const void *  rs, const uint64_t *  string, const size_t length) {
+    const uint64_t *  randomsource = (const uint64_t *) rs;
+    unsigned __int128 sum = __multilinear64Key(randomsource);
+    randomsource += 2;
+    size_t i = 0;
+#ifdef __AVX512F__
+    // blocks of 2^30 words keep the column sums of __multilinear64Sum512 exact
+    while (length - i >= 8) {
+        size_t block = (length - i) & ~(size_t) 7;
+        if (block > ((size_t) 1 << 30))
+            block = (size_t) 1 << 30;
+        sum += __multilinear64Sum512(randomsource + 2 * i, string + i, block);
+        i += block;
+    }
+#endif
+    sum += __multilinear64Scalar(randomsource + 2 * i, string + i, length - i);
+    sum += __multilinear64Key(randomsource + 2 * length);
+    return (uint64_t) (sum >> 64);
+}
+
+AVX512_KERNELS_END
+
 
 #include "City/City.h"
 
@@ -33,96 +179,78 @@ uint64_t hashSipHash(const void*  rs, const uint64_t *  string, const size_t len
     return answer;
 }
 
+// SipHash-1-3 (fewer rounds than SipHash-2-4, meant for hash tables)
+uint64_t hashSipHash13(const void*  rs, const uint64_t *  string, const size_t length) {
+    uint64_t answer;
+    siphash13((uint8_t * ) &answer, (const uint8_t * )string, length *sizeof(uint64_t), (const uint8_t *)rs );
+    return answer;
+}
+
+#include "SipHash/halfsiphash.h"
+// HalfSipHash-2-4 with its 64-bit output
+uint64_t hashHalfSipHash64(const void*  rs, const uint64_t *  string, const size_t length) {
+    uint64_t answer;
+    halfsiphash((uint8_t * ) &answer, (const uint8_t * )string, length *sizeof(uint64_t), (const uint8_t *)rs, 8 );
+    return answer;
+}
+
 
 
 #include "VHASH/vmac.h"
 #include <string.h>
-// to simulate the speed of VHASH. Not thread safe.
-// This is not correct if the input is not divisible by 16 bytes.
-uint64_t hashVHASH64(const void*  rs, const uint64_t *  string, const size_t length) {
-    static vmac_ctx_t ctx; // we need a ctx struct
-    /*
-     * At least once, we need the following call:
-     *
-     * vmac_set_key(rs, &ctx)
-     *
-     * Doing so each time would almost surely handicap the speed of the function, so
-     * we only do it if our heuristic suggests that it is necessary.
-     *
-     * This heuristic can be defeated: (1) we could end up calling vmac_set_key
-     * unnecessarily (2) we could fail to call it even though it is necessary.
-     * Neither of these problems will occur in our benchmark.
-     *
-     *
-     */
-    static const void *initialized_rs = 0;
-    static uint64 first_value = 0;
-
-    //  initialize, hoping a change of randoms will change the first value or the buffer location
-    if (rs != initialized_rs || (first_value != *((uint64*) rs))) {
-        vmac_set_key((unsigned char *) rs, &ctx);
-        initialized_rs = rs;
-        first_value = *((uint64*) rs);
-    }
 
-    uint64_t tagl;// I think that this is useless but I am not sure, still needed due to API
-    /*
-     * If the input is divisible by = VMAC_NHBYTES16 bytes, then we can call VHASH directly
-     * otherwise we have to do something messy due to alignment requirements in VHASH.
-     */
-    size_t inputlengthinbytes = length * sizeof(uint64_t);
-    return vhash((unsigned char *)string, inputlengthinbytes, &tagl, &ctx);
+/*
+ * A VHASH key has to be prepared by vmac_set_key (AES key schedule plus AES-derived
+ * NH, poly and L3 keys), which costs far more than hashing a short string.
+ * vhash_prepare_ctx does this once for a key; a prepared context can be reused for
+ * any number of vhash calls, but vhash writes to it, so it must not be shared
+ * between threads.
+ */
+typedef struct {
+    const void * rs; // where the key was read from
+    unsigned char key[VMAC_KEY_LEN / 8]; // the bytes vmac_set_key consumed
+    vmac_ctx_t ctx;
+} vhash_prepared_ctx_t;
+
+void vhash_prepare_ctx(vhash_prepared_ctx_t * prepared, const void * rs) {
+    prepared->rs = rs;
+    memcpy(prepared->key, rs, sizeof(prepared->key));
+    vmac_set_key(prepared->key, &prepared->ctx);
 }
 
-// to simulate the speed of VHASH. Not thread safe.
-// This is  correct even the input is not divisible by 16 bytes, but slower than hashVHASH64.
-uint64_t saferhashVHASH64(const void*  rs, const uint64_t *  string, const size_t length) {
-    static vmac_ctx_t ctx; // we need a ctx struct
-    /*
-     * At least once, we need the following call:
-     *
-     * vmac_set_key(rs, &ctx)
-     *
-     * Doing so each time would almost surely handicap the speed of the function, so
-     * we only do it if our heuristic suggests that it is necessary.
-     *
-     * This heuristic can be defeated: (1) we could end up calling vmac_set_key
-     * unnecessarily (2) we could fail to call it even though it is necessary.
-     * Neither of these problems will occur in our benchmark.
-     *
-     *
-     */
-    static const void *initialized_rs = 0;
-    static uint64 first_value = 0;
-
-    //  initialize, hoping a change of randoms will change the first value or the buffer location
-    if (rs != initialized_rs || (first_value != *((uint64*) rs))) {
-        vmac_set_key((unsigned char *) rs, &ctx);
-        initialized_rs = rs;
-        first_value = *((uint64*) rs);
+#define VHASH_THREAD_CTX_CACHE_SIZE 4
+
+// Returns the calling thread's prepared context for the key at rs, preparing it on a miss.
+// Entries match on both the key address and the key bytes, so rewriting a key in place is noticed.
+vmac_ctx_t * vhash_thread_ctx(const void * rs) {
+    static __thread vhash_prepared_ctx_t cache[VHASH_THREAD_CTX_CACHE_SIZE];
+    static __thread unsigned int filled, next;
+    unsigned int i;
+    for (i = 0; i < filled; ++i) {
+        if ((cache[i].rs == rs) && (memcmp(cache[i].key, rs, sizeof(cache[i].key)) == 0))
+            return &cache[i].ctx;
     }
-    uint64_t tagl;// I think that this is useless but I am not sure, still needed due to API
-    /*
-     * If the input is divisible by = VMAC_NHBYTES16 bytes, then we can call VHASH directly
-     * otherwise we have to do something messy due to alignment requirements in VHASH.
-     */
-    size_t inputlengthinbytes = length * sizeof(uint64_t);
-    return vhash((unsigned char *)string, inputlengthinbytes, &tagl, &ctx);
-    if((inputlengthinbytes % VMAC_NHBYTES) == 0) {
-        return vhash((unsigned char *)string, inputlengthinbytes, &tagl, &ctx);
+    // replace entries round-robin once the cache is full
+    if (filled < VHASH_THREAD_CTX_CACHE_SIZE) {
+        i = filled++;
     } else {
-        size_t roundedlength = inputlengthinbytes/VMAC_NHBYTES*VMAC_NHBYTES;
-        vhash_update((unsigned char*)string, roundedlength, &ctx);
-        if(roundedlength > 0) vhash_update((unsigned char*)string, roundedlength, &ctx);
-        static unsigned char lastBlock[VMAC_NHBYTES + 16];
-        unsigned char *alignedptr = (unsigned char*)(((uintptr_t)lastBlock+15) & ~ (uintptr_t)0x0F);
-        size_t remaining = inputlengthinbytes - roundedlength;
-        memcpy(alignedptr, (unsigned char*)string + roundedlength, remaining);
-        memset(alignedptr + remaining, 0, VMAC_NHBYTES - remaining );
-        return vhash(alignedptr, remaining, &tagl, &ctx);
+        i = next;
+        next = (next + 1) % VHASH_THREAD_CTX_CACHE_SIZE;
     }
+    vhash_prepare_ctx(&cache[i], rs);
+    return &cache[i].ctx;
 }
 
+// VHASH (the universal hash inside VMAC)
+uint64_t hashVHASH64(const void*  rs, const uint64_t *  string, const size_t length) {
+    uint64_t tagl;// I think that this is useless but I am not sure, still needed due to API
+    return vhash_bytes((const unsigned char *)string, length * sizeof(uint64_t), &tagl, vhash_thread_ctx(rs));
+}
+
+// same as hashVHASH64, kept for older callers (hashVHASH64 used to read past inputs not divisible by 16 bytes)
+uint64_t saferhashVHASH64(const void*  rs, const uint64_t *  string, const size_t length) {
+    return hashVHASH64(rs, string, length);
+}
 
 
 
@@ -7,6 +7,7 @@
 #include "clmulpoly64bits.h"
 #include "clhash.h"
 #include "clmulhierarchical64bits.h"
+#include "ghash.h"
 
 #ifdef __PCLMUL__
 
@@ -787,8 +788,357 @@ void clhashsanity() {
 
 }
 
+void widemultiplicationtest() {
+    printf("[widemultiplication] Checking the 128x128 product kernels against each other \n");
+    __m128i A[8], B[8];
+    uint64_t x = 3;
+    for(int trial = 0; trial < 1000; ++trial) {
+        for(int k = 0; k < 8; ++k) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            A[k] = _mm_set_epi64x(x, x * 0x9E3779B97F4A7C15ULL);
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            B[k] = _mm_set_epi64x(x * 0xC2B2AE3D27D4EB4FULL, x);
+        }
+        __m128i lo[8], hi[8], lo2, hi2, sumlo = _mm_setzero_si128(), sumhi = _mm_setzero_si128();
+        for(int k = 0; k < 8; ++k) {
+            mul128by128to256_schoolbook(A[k], B[k], &lo[k], &hi[k]);
+            mul128by128to256_karatsuba(A[k], B[k], &lo2, &hi2);
+            assert(equal(lo[k], lo2) && equal(hi[k], hi2));
+            mul128by128to256_clmul(A[k], B[k], &lo2, &hi2);
+            assert(equal(lo[k], lo2) && equal(hi[k], hi2));
+        }
+        mul128by128to256_2by2(A[0], A[1], B[0], B[1], &lo2, &hi2);
+        assert(equal(lo2, _mm_xor_si128(lo[0], lo[1])) && equal(hi2, _mm_xor_si128(hi[0], hi[1])));
+        mul128by128to256_4by4(A[0], A[1], A[2], A[3], B[0], B[1], B[2], B[3], &lo2, &hi2);
+        __m128i lo4, hi4;
+        mul128by128to256_sum(A, B, 4, &lo4, &hi4);
+        assert(equal(lo2, lo4) && equal(hi2, hi4));
+        for(size_t n = 0; n <= 8; ++n) {
+            mul128by128to256_sum(A, B, n, &lo2, &hi2);
+            assert(equal(lo2, sumlo) && equal(hi2, sumhi));
+            if(n < 8) {
+                sumlo = _mm_xor_si128(sumlo, lo[n]);
+                sumhi = _mm_xor_si128(sumhi, hi[n]);
+            }
+        }
+#if CLMUL_WIDE
+        __m128i lanes[8];
+        __m256i lo256, hi256;
+        mul128by128to256_si256(_mm256_loadu_si256((const __m256i *) A), _mm256_loadu_si256((const __m256i *) B),
+                               &lo256, &hi256);
+        _mm256_storeu_si256((__m256i *) lanes, lo256);
+        _mm256_storeu_si256((__m256i *) (lanes + 2), hi256);
+        assert(equal(lanes[0], lo[0]) && equal(lanes[1], lo[1]) && equal(lanes[2], hi[0]) && equal(lanes[3], hi[1]));
+#if CLMUL_WIDE == 512
+        __m512i lo512, hi512;
+        mul128by128to256_si512(_mm512_loadu_si512((const void *) A), _mm512_loadu_si512((const void *) B),
+                               &lo512, &hi512);
+        _mm512_storeu_si512((void *) lanes, lo512);
+        _mm512_storeu_si512((void *) (lanes + 4), hi512);
+        for(int k = 0; k < 4; ++k)
+            assert(equal(lanes[k], lo[k]) && equal(lanes[4 + k], hi[k]));
+#endif
+#endif
+    }
+    printf("Test passed! \n");
+}
+
+void batchreductiontest() {
+    printf("[batchreduction] Checking the batched reductions against the one-at-a-time ones \n");
+    __m128i A[8], B[8], lazy[8];
+    uint64_t r64[8];
+    uint32_t r32[8];
+    uint64_t x = 1;
+    for(int trial = 0; trial < 1000; ++trial) {
+        for(int k = 0; k < 8; ++k) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            const uint64_t y = x * 0x9E3779B97F4A7C15ULL;
+            A[k] = _mm_set_epi64x(x, y);
+            B[k] = _mm_set_epi64x(y >> 2, x); // lazymod127 needs the two highest bits clear
+        }
+        for(int width = 2; width <= 8; width *= 2) {
+            if(width == 2) {
+                precompReduction64_x2(A, r64);
+                barrettWithoutPrecomputation32_x2(A, r32);
+                lazymod127_x2(A, B, lazy);
+            } else if(width == 4) {
+                precompReduction64_x4(A, r64);
+                barrettWithoutPrecomputation32_x4(A, r32);
+                lazymod127_x4(A, B, lazy);
+            } else {
+                precompReduction64_x8(A, r64);
+                barrettWithoutPrecomputation32_x8(A, r32);
+                lazymod127_x8(A, B, lazy);
+            }
+            for(int k = 0; k < width; ++k) {
+                if((r64[k] != precompReduction64(A[k])) || (r32[k] != barrettWithoutPrecomputation32(A[k]))
+                        || !equal(lazy[k], lazymod127(A[k], B[k]))) {
+                    printf("bug in batches of %d (accumulator %d)\n", width, k);
+                    abort();
+                }
+            }
+        }
+    }
+    printf("Test passed! \n");
+}
+
+void ghash8waytest() {
+    printf("[ghash8way] Checking the 8-way GHASH against GHASH_m128 \n");
+    uint64_t key[2] = {0x123456789abcdefULL, 0xfedcba9876543210ULL};
+    uint64_t otherkey[2] = {0x0f1e2d3c4b5a6978ULL, 0x8796a5b4c3d2e1f0ULL};
+    uint64_t data[300];
+    for(int k = 0; k < 300; ++k) {
+        data[k] = k * 0x9E3779B97F4A7C15ULL + 7;
+    }
+    __m128i powers[8];
+    ghash_precompute_powers8(_mm_loadu_si128((const __m128i *) key), powers);
+    for(size_t length = 0; length < 300; ++length) {
+        __m128i r1 = GHASH_m128(_mm_loadu_si128((const __m128i *) key), data, length);
+        __m128i r2 = GHASH_m128_8way(powers, data, length);
+        if(!equal(r1, r2)) {
+            printf("bug at length %zu\n", length);
+            printme64(r1);
+            printme64(r2);
+            printf("\n");
+            abort();
+        }
+        // the adapter caches the powers of the last key: alternate keys to exercise that
+        const uint64_t * k = (length & 1) ? otherkey : key;
+        if(GHASH64bit8way(k, data, length) != GHASH64bit(k, data, length)) {
+            printf("bug in GHASH64bit8way at length %zu\n", length);
+            abort();
+        }
+    }
+    printf("Test passed! \n");
+}
+
+void ghashstreamtest() {
+    printf("[ghashstream] Checking streaming GHASH and POLYVAL \n");
+    // RFC 8452, appendix A
+    const uint8_t H[16] = {0x25, 0x62, 0x93, 0x47, 0x58, 0x92, 0x42, 0x76,
+                           0x1d, 0x31, 0xf8, 0x26, 0xba, 0x4b, 0x75, 0x7b};
+    const uint8_t X[32] = {0x4f, 0x4f, 0x95, 0x66, 0x8c, 0x83, 0xdf, 0xb6,
+                           0x40, 0x17, 0x62, 0xbb, 0x2d, 0x01, 0xa2, 0x62,
+                           0xd1, 0xa2, 0x4d, 0xdd, 0x27, 0x21, 0xd0, 0x06,
+                           0xbb, 0xe4, 0x5f, 0x20, 0xd3, 0xc9, 0xf3, 0x62};
+    const uint8_t expected[16] = {0xf7, 0xa3, 0xb4, 0x7b, 0x84, 0x61, 0x19, 0xfa,
+                                  0xe5, 0xb7, 0x86, 0x6c, 0xf5, 0xe5, 0xb7, 0x7e};
+    __m128i polyvalpowers[8], ghashpowers[8];
+    polyval_precompute_powers8(_mm_loadu_si128((const __m128i *) H), polyvalpowers);
+    assert(equal(POLYVAL_m128(polyvalpowers, (const uint64_t *) X, 4),
+                 _mm_loadu_si128((const __m128i *) expected)));
+    uint64_t key[2] = {0x123456789abcdefULL, 0xfedcba9876543210ULL};
+    ghash_precompute_powers8(_mm_loadu_si128((const __m128i *) key), ghashpowers);
+    polyval_precompute_powers8(_mm_loadu_si128((const __m128i *) key), polyvalpowers);
+    uint64_t data[301], padded[301];
+    for(int k = 0; k < 301; ++k) {
+        data[k] = k * 0x9E3779B97F4A7C15ULL + 7;
+    }
+    uint32_t r = 1;
+    for(size_t bytes = 0; bytes < 300 * 8; bytes += 13) {
+        // one-shot reference: the string zero-padded to whole words
+        memset(padded, 0, sizeof(padded));
+        memcpy(padded, data, bytes);
+        for(int polyval = 0; polyval < 2; ++polyval) {
+            ghash_stream_t stream;
+            if(polyval) polyval_stream_init(&stream, polyvalpowers);
+            else ghash_stream_init(&stream, ghashpowers);
+            for(size_t offset = 0; offset < bytes; ) {
+                r = r * 1103515245 + 12345;
+                size_t piece = (r >> 16) % 200;
+                if(piece > bytes - offset) piece = bytes - offset;
+                ghash_stream_update(&stream, (const char *) data + offset, piece);
+                offset += piece;
+            }
+            __m128i streamed = ghash_stream_final(&stream);
+            __m128i oneshot = polyval ? POLYVAL_m128(polyvalpowers, padded, (bytes + 7) / 8)
+                              : GHASH_m128(_mm_loadu_si128((const __m128i *) key), padded, (bytes + 7) / 8);
+            if(!equal(streamed, oneshot)) {
+                printf("bug at %zu bytes (%s)\n", bytes, polyval ? "POLYVAL" : "GHASH");
+                abort();
+            }
+        }
+    }
+    printf("Test passed! \n");
+}
+
+// CLMULPoly64CL2 on lengths 0 to 799, from a 16-byte aligned string and not, against
+// digests computed with CLMUL_WIDE=0 (the xmm loop); each digest folds a block of 100 lengths
+void clmulpoly64cl2test() {
+    printf("[%s] checking CLMULPoly64CL2 against the xmm loop\n", __func__);
+    enum { WORDS = 800, BLOCK = 100 };
+    static const uint64_t expected[2][WORDS / BLOCK] = {
+        {0xab5727f75c2a9bdfULL, 0x24560b39d836085bULL, 0x1e715b158e7d06cdULL, 0x593f86219f1922d1ULL,
+         0xe5744a08f268a893ULL, 0x19c2fd7e3d0031daULL, 0x383e8782d23331dfULL, 0x550fb690a72d4277ULL},
+        {0xc4b7f49a56997830ULL, 0xb9352f36b00a13adULL, 0x362cd3358df53fe0ULL, 0xa733a9e0d388023eULL,
+         0xadb94277cdaacfebULL, 0x206768e700cba242ULL, 0x774919912e038798ULL, 0x3cfbf7c9d4f7b5b7ULL}
+    };
+    static uint64_t data[WORDS + 2] __attribute__((aligned(16)));
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for(int i = 0; i < WORDS + 2; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        data[i] = state;
+    }
+    __m128i powers[8];
+    precomputePowers(0xd1b54a32d192ed03ULL, powers);
+    for(size_t offset = 0; offset < 2; ++offset) {
+        for(size_t block = 0; block < WORDS / BLOCK; ++block) {
+            uint64_t fold = 0;
+            for(size_t length = block * BLOCK; length < (block + 1) * BLOCK; ++length)
+                fold = fold * 0x9E3779B97F4A7C15ULL + CLMULPoly64CL2(powers, data + offset, length);
+            if(fold != expected[offset][block]) {
+                printf("bug at lengths %zu to %zu, offset %zu\n", block * BLOCK, (block + 1) * BLOCK - 1, offset);
+                abort();
+            }
+        }
+    }
+    printf("Test passed! \n");
+}
+
+// clmulpoly64_hash at every depth against Horner's rule, one reduction per word
+void clmulpoly64test() {
+    printf("[%s] checking the prepared-key polynomial hash\n", __func__);
+    uint64_t data[301];
+    for(int i = 0; i < 301; ++i) data[i] = ((uint64_t) rand() << 33) ^ ((uint64_t) rand() << 11) ^ rand();
+    const uint64_t randomp = 0xd1b54a32d192ed03ULL;
+    const __m128i p = _mm_cvtsi64_si128((long long) randomp);
+    const int depths[] = {8, 16, 32, 64};
+    for(size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d) {
+        clmulpoly64_key_t key;
+        clmulpoly64_prepare_key(&key, randomp, depths[d]);
+        for(size_t offset = 0; offset < 2; ++offset) { // 16-byte aligned and not
+            const uint64_t * string = data + offset;
+            uint64_t expected = 0;
+            for(size_t length = 0; length <= 300; ++length) {
+                if(clmulpoly64_hash(&key, string, length) != expected) {
+                    printf("bug at depth %d, length %zu, offset %zu\n", depths[d], length, offset);
+                    abort();
+                }
+                if(length < 300)
+                    expected = precompReduction64(_mm_clmulepi64_si128(
+                                   _mm_cvtsi64_si128((long long)(expected ^ string[length])), p, 0x00));
+            }
+        }
+    }
+    if(CLMULPoly64x8(&randomp, data, 300)
+            != clmulpoly64_hash(clmulpoly64_thread_key(&randomp, CLMULPOLY64_DEFAULT_DEPTH), data, 300)) {
+        printf("bug in CLMULPoly64x8\n");
+        abort();
+    }
+    printf("Test passed! \n");
+}
+
+// clmulpoly_combine on every split of a string, and a rope kept up to date while its
+// pieces are replaced
+void clmulpolycombinetest() {
+    printf("[%s] checking the combination of polynomial hashes\n", __func__);
+    enum { WORDS = 400, PIECES = 13 };
+    uint64_t data[WORDS];
+    for(int i = 0; i < WORDS; ++i) data[i] = ((uint64_t) rand() << 33) ^ ((uint64_t) rand() << 11) ^ rand();
+    clmulpoly64_key_t key;
+    clmulpoly64_prepare_key(&key, 0x9e3779b97f4a7c15ULL, 16);
+    for(size_t length = 0; length <= WORDS; length += 7) {
+        const uint64_t whole = clmulpoly64_hash(&key, data, length);
+        for(size_t split = 0; split <= length; ++split) {
+            if(clmulpoly_combine(clmulpoly64_hash(&key, data, split),
+                                 clmulpoly64_hash(&key, data + split, length - split),
+                                 length - split, &key) != whole) {
+                printf("bug at length %zu, split %zu\n", length, split);
+                abort();
+            }
+        }
+    }
+    // piece k is data[start[k], start[k] + len[k]); the pieces are laid out one after the
+    // other in concat to check the root
+    size_t len[PIECES];
+    uint64_t concat[PIECES * WORDS];
+    clmulpoly64_rope_t rope;
+    if(clmulpoly64_rope_init(&rope, &key, PIECES) != 0) {
+        printf("allocation failure\n");
+        abort();
+    }
+    if(clmulpoly64_rope_hash(&rope) != 0) {
+        printf("bug: empty rope\n");
+        abort();
+    }
+    for(int k = 0; k < PIECES; ++k) len[k] = 0;
+    for(int round = 0; round < 200; ++round) {
+        const int k = rand() % PIECES;
+        const size_t start = rand() % WORDS;
+        len[k] = rand() % (WORDS - start + 1);
+        memcpy(concat + k * WORDS, data + start, len[k] * sizeof(uint64_t));
+        clmulpoly64_rope_set(&rope, k, data + start, len[k]);
+        uint64_t joined[PIECES * WORDS];
+        size_t total = 0;
+        for(int j = 0; j < PIECES; ++j) {
+            memcpy(joined + total, concat + j * WORDS, len[j] * sizeof(uint64_t));
+            total += len[j];
+        }
+        if(clmulpoly64_rope_hash(&rope) != clmulpoly64_hash(&key, joined, total)) {
+            printf("bug in the rope after %d updates\n", round + 1);
+            abort();
+        }
+    }
+    clmulpoly64_rope_free(&rope);
+    printf("Test passed! \n");
+}
+
+// substrings from a prefix-hash index at both strides against clmulpoly64_hash, also after
+// reattaching a copy of the index storage
+void clmulpolyprefixtest() {
+    printf("[%s] checking substring hashes from the prefix index\n", __func__);
+    enum { WORDS = 3000 };
+    static uint64_t data[WORDS];
+    for(int i = 0; i < WORDS; ++i) data[i] = ((uint64_t) rand() << 33) ^ ((uint64_t) rand() << 11) ^ rand();
+    clmulpoly64_key_t key;
+    const size_t lengths[] = {0, 1, 5, 63, 64, 65, 600, 1023, 1024, 1500, WORDS};
+    for(int depth = 16; depth <= 64; depth *= 4) {
+        clmulpoly64_prepare_key(&key, 0x2545f4914f6cdd1dULL + depth, depth);
+        for(size_t stride = 1; stride <= (size_t) depth; stride += depth - 1) {
+            for(size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); ++l) {
+                const size_t length = lengths[l];
+                const size_t words = clmulpoly64_prefix_index_words(length, stride, depth);
+                uint64_t * storage = (uint64_t *) malloc(words * sizeof(uint64_t));
+                uint64_t * copy = (uint64_t *) malloc(words * sizeof(uint64_t));
+                clmulpoly64_prefix_index_t index, reattached;
+                clmulpoly64_prefix_index_build(&index, &key, data, length, stride, storage);
+                memcpy(copy, storage, words * sizeof(uint64_t));
+                clmulpoly64_prefix_index_attach(&reattached, &key, data, length, stride, copy);
+                for(int trial = 0; trial < 2000; ++trial) {
+                    size_t i = rand() % (length + 1), j = rand() % (length + 1);
+                    if(trial < 100) j = (i + trial > length) ? length : i + trial; // short ones too
+                    if(i > j) {
+                        const size_t t = i;
+                        i = j;
+                        j = t;
+                    }
+                    const uint64_t expected = clmulpoly64_hash(&key, data + i, j - i);
+                    if((clmulpoly64_substring_hash(&index, i, j) != expected)
+                            || (clmulpoly64_substring_hash(&reattached, i, j) != expected)) {
+                        printf("bug at depth %d, stride %zu, length %zu, [%zu, %zu)\n", depth, stride, length, i, j);
+                        abort();
+                    }
+                }
+                free(storage);
+                free(copy);
+            }
+        }
+    }
+    printf("Test passed! \n");
+}
+
 int main() {
     clhashsanity();
+    widemultiplicationtest();
+    batchreductiontest();
+    ghash8waytest();
+    ghashstreamtest();
+    clmulpoly64test();
+    clmulpoly64cl2test();
+    clmulpolycombinetest();
+    clmulpolyprefixtest();
     clhashavalanchetest();
     lazymod128test();
     lazymod128test2();
@@ -7,16 +7,27 @@
 #include <cstdio>
 #include <cstdlib>
 #include <string.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
 extern "C" {
+#include "hashfunctions32bits.h"
 #include "hashfunctions64bits.h"
 #include "pcg.h"
 #include "clmulhierarchical64bits.h"
+#include "clmulhashfunctions32bits.h"
 }
+#include "bigendianuniversal.h"
+#include "PMP/PMP_Multilinear_64.h"
 
 #include "treehash/binary-treehash.hh"
 #include "treehash/generic-treehash.hh"
@@ -31,9 +42,13 @@ struct NamedFunc {
 
 NamedFunc hashFunctions[] = {
   NAMED((&hashPMP64)),
+  NAMED((&hashPMP32_64)),
+  NAMED((&hashPMP64out32_64)),
   NAMED((&CLHASH)),
   NAMED((&hashCity)),
   NAMED((&hashSipHash)),
+  NAMED((&hashSipHash13)),
+  NAMED((&hashHalfSipHash64)),
   NAMED((&hashVHASH64)),
   NAMED((&generic_treehash<BoostedZeroCopyGenericBinaryTreehash, CLNH, 7>)),
   NAMED((&generic_treehash<BoostedZeroCopyGenericBinaryTreehash, NHCL, 7>)),
@@ -156,12 +171,643 @@ endoflength:
     return result;
 }
 
+// the multithreaded PMP64 must give the same digests as the serial one
+int testparallelpmp() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    const size_t maxlength = (size_t(1) << 24) + 1000;
+    unsigned char * chars = (unsigned char *) malloc(maxlength);
+    for (size_t i = 0; i < maxlength; ++i) {
+        chars[i] = (unsigned char) pcg64_random();
+    }
+    const size_t lengths[] = {0, 7, 1024, 256 * 1024 - 1, 512 * 1024, 512 * 1024 + 5,
+                              (size_t(1) << 20) + 1023, (size_t(1) << 24) + 1000};
+    int result = 0;
+    for (size_t length : lengths) {
+        const uint64_t serial = pmp64_hash(chars, length);
+        for (unsigned int threads = 1; threads <= 8; ++threads) {
+            if (pmp64_hash_parallel(chars, length, threads) != serial) {
+                cerr << "pmp64_hash_parallel differs from pmp64_hash for length "
+                     << length << " and " << threads << " threads" << endl;
+                result = 1;
+            }
+        }
+    }
+    free(chars);
+    return result;
+}
+
+// coefficient tables generated at compile time must respect randomize()'s invariants
+int testseededpmp() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    const random_data_for_PMPML_64 * rd = PMPML_Seeded_Coefficients_64<UINT64_C(0x5eed)>::rd;
+    int result = 0;
+    for (int i = 0; i < PMPML_LEVELS_64; ++i) {
+        uint64_t lo = 0, hi = 0;
+        for (int j = 0; j < PMPML_CHUNK_SIZE_64; ++j) {
+            if (!IS_VALID_COEFFICIENT_64(rd[i].random_coeff[j], i)) {
+                cerr << "invalid seeded coefficient at level " << i << endl;
+                result = 1;
+            }
+            lo += rd[i].random_coeff[j];
+            if (lo < rd[i].random_coeff[j]) hi += 1;
+        }
+        if (lo != rd[i].cachedSumLow || hi != rd[i].cachedSumHigh) {
+            cerr << "bad cached sum in seeded table at level " << i << endl;
+            result = 1;
+        }
+    }
+    PMP_Multilinear_Hasher_64 seeded(rd), fixed(rd_for_PMPML_64), reference;
+    unsigned char chars[4096];
+    for (size_t i = 0; i < sizeof(chars); ++i) chars[i] = (unsigned char) pcg64_random();
+    if (fixed.hash(chars, sizeof(chars)) != reference.hash(chars, sizeof(chars))
+            || seeded.hash(chars, sizeof(chars)) == reference.hash(chars, sizeof(chars))) {
+        cerr << "hasher does not follow its coefficient table" << endl;
+        result = 1;
+    }
+    return result;
+}
+
+// PMP64 digests with the fixed coefficients, as computed by the scalar chunk loops (built
+// with PMPML_NO_AVX512_64): the AVX-512 kernels must give the same values. The digests of
+// each run of 100 lengths, from 0 to 3200 bytes, are folded into one word.
+int testpmpavx512() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    static const uint64_t folded[] = {
+        UINT64_C(0xe26c0c428977d137), UINT64_C(0x37e19ffa766f9213), UINT64_C(0x201a97caee9a666e),
+        UINT64_C(0x80d8605b703ef3ce), UINT64_C(0x6c9289ebd3358a8c), UINT64_C(0x3859e50923b97994),
+        UINT64_C(0x79269dfb214dff7b), UINT64_C(0xd97183def3423ebf), UINT64_C(0x4ef4dfdbf8900106),
+        UINT64_C(0xad665d1a23d25c64), UINT64_C(0x413cc4201347ba7e), UINT64_C(0x0059b4e101f9639e),
+        UINT64_C(0x819c940478255bf8), UINT64_C(0x45a929f9df0e7f92), UINT64_C(0x328886007d8c5b49),
+        UINT64_C(0xd82095a9edfc8755), UINT64_C(0xee889c4fba862189), UINT64_C(0xf9a0a96666276a7c),
+        UINT64_C(0x7d6331c5e75c1374), UINT64_C(0x25f2b6f0df16b3a8), UINT64_C(0xb4fc4fd70c291ee5),
+        UINT64_C(0x2eac79ad4d343fec), UINT64_C(0x14ac18432f55f6e4), UINT64_C(0xe1db896269d654c5),
+        UINT64_C(0xadb711eda91a675e), UINT64_C(0xbd2b71a5c6c7d9dc), UINT64_C(0xc089883c9ec787d8),
+        UINT64_C(0x0dca3558fd4c8a12), UINT64_C(0x11056bfa808f8f4e), UINT64_C(0x64c1ca2d84f99dc4),
+        UINT64_C(0x2ddd5b2d1f5489d4), UINT64_C(0xa5eefdac771a5f70), UINT64_C(0xc8038379bade7d2e)
+    };
+    const size_t longlengths[] = {131077, 393293, 8388621};
+    static const uint64_t longdigests[] = {UINT64_C(0x1e8ba1f562072f8f), UINT64_C(0x0ed3eaaafbc148f4),
+                                           UINT64_C(0x1a335a5802431a53)};
+    vector<unsigned char> chars(longlengths[2]);
+    uint64_t state = UINT64_C(0x9e3779b97f4a7c15);
+    for (size_t i = 0; i < chars.size(); ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        chars[i] = (unsigned char) state;
+    }
+    const PMP_Multilinear_Hasher_64 hasher;
+    int result = 0;
+    for (size_t b = 0; b < sizeof(folded) / sizeof(folded[0]); ++b) {
+        uint64_t fold = 0;
+        for (size_t length = 100 * b; length < 100 * b + 100 && length <= 3200; ++length)
+            fold = fold * UINT64_C(0x9E3779B97F4A7C15) + hasher.hash(chars.data(), length);
+        if (fold != folded[b]) {
+            cerr << "PMP64 differs from its scalar digests for lengths " << 100 * b << " to "
+                 << 100 * b + 99 << endl;
+            result = 1;
+        }
+    }
+    for (size_t i = 0; i < sizeof(longlengths) / sizeof(longlengths[0]); ++i) {
+        if (hasher.hash(chars.data(), longlengths[i]) != longdigests[i]) {
+            cerr << "PMP64 differs from its scalar digest for length " << longlengths[i] << endl;
+            result = 1;
+        }
+    }
+    return result;
+}
+
+// hashVHASH64 keeps prepared keys per thread: concurrent callers with more keys than
+// cache entries, and a key rewritten in place, must still get the single-threaded digests
+int testthreadedvhash() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    const int keys = VHASH_THREAD_CTX_CACHE_SIZE + 2, threads = 4, length = 300;
+    uint64_t randbuffer[keys][16] __attribute__ ((aligned (16)));
+    uint64_t intstring[length];
+    for (int k = 0; k < keys; ++k)
+        for (int i = 0; i < 16; ++i) randbuffer[k][i] = pcg64_random();
+    for (int i = 0; i < length; ++i) intstring[i] = pcg64_random();
+    uint64_t expected[keys];
+    for (int k = 0; k < keys; ++k) {
+        vhash_prepared_ctx_t prepared;
+        uint64_t tagl;
+        vhash_prepare_ctx(&prepared, randbuffer[k]);
+        expected[k] = vhash((unsigned char *) intstring, length * sizeof(uint64_t), &tagl, &prepared.ctx);
+    }
+    int result = 0;
+    std::vector<int> failures(threads, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(std::thread([&, t]() {
+            for (int round = 0; round < 1000; ++round) {
+                const int k = (round * (t + 1)) % keys;
+                if (hashVHASH64(randbuffer[k], intstring, length) != expected[k]) failures[t] = 1;
+            }
+        }));
+    }
+    for (int t = 0; t < threads; ++t) {
+        workers[t].join();
+        result |= failures[t];
+    }
+    const uint64_t before = hashVHASH64(randbuffer[0], intstring, length);
+    randbuffer[0][1] ^= 1;
+    if (hashVHASH64(randbuffer[0], intstring, length) == before) result = 1;
+    randbuffer[0][1] ^= 1;
+    if (hashVHASH64(randbuffer[0], intstring, length) != before) result = 1;
+    if (result) cerr << "hashVHASH64 disagrees with a freshly prepared VHASH context" << endl;
+    return result;
+}
+
+// streaming and byte-length VHASH must agree with vhash over the message zero padded to 16 bytes
+int teststreamingvhash() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    const size_t maxlength = 4 * VMAC_NHBYTES + 40;
+    unsigned char key[16], message[maxlength], padded[maxlength + 16];
+    for (size_t i = 0; i < sizeof(key); ++i) key[i] = (unsigned char) pcg64_random();
+    for (size_t i = 0; i < maxlength; ++i) message[i] = (unsigned char) pcg64_random();
+    vhash_prepared_ctx_t prepared;
+    vhash_prepare_ctx(&prepared, key);
+    int result = 0;
+    for (size_t length = 0; length <= maxlength; ++length) {
+        uint64_t tagl;
+        memset(padded, 0, sizeof(padded));
+        memcpy(padded, message, length);
+        const uint64_t expected = vhash(padded, length, &tagl, &prepared.ctx);
+        if (vhash_bytes(message, length, &tagl, &prepared.ctx) != expected) result = 1;
+        for (size_t piece = 1; piece <= VMAC_NHBYTES + 1; piece += 9) {
+            vhash_stream_t stream;
+            vhash_stream_init(&stream, &prepared.ctx);
+            for (size_t i = 0; i < length; i += piece)
+                vhash_stream_update(&stream, message + i, (length - i < piece) ? length - i : piece);
+            if (vhash_stream_final(&stream, &tagl) != expected) result = 1;
+        }
+    }
+    if (result) cerr << "streaming or byte-length VHASH differs from padded vhash" << endl;
+    return result;
+}
+
+// siphash_batch must reproduce siphash for every lane, lengths differing within a batch
+int testsiphashbatch() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    const size_t maxcount = 37, maxlength = 150;
+    uint8_t key[16], storage[maxcount * maxlength];
+    for (size_t i = 0; i < sizeof(key); ++i) key[i] = (uint8_t) pcg64_random();
+    for (size_t i = 0; i < sizeof(storage); ++i) storage[i] = (uint8_t) pcg64_random();
+    const uint8_t * in[maxcount];
+    uint64_t inlen[maxcount], out[maxcount];
+    int result = 0;
+    for (size_t count = 0; count <= maxcount; ++count) {
+        for (size_t i = 0; i < count; ++i) {
+            in[i] = storage + i * maxlength;
+            inlen[i] = pcg64_random() % ((count % 2) ? maxlength : 17);
+        }
+        siphash_batch(out, in, inlen, count, key);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t expected;
+            siphash((uint8_t *) &expected, in[i], inlen[i], key);
+            if (out[i] != expected) result = 1;
+        }
+    }
+    if (result) cerr << "siphash_batch differs from siphash" << endl;
+    return result;
+}
+
+// reference vectors: key 00..0f (00..07 for HalfSipHash), message 00 01 02 ...
+int testsipvariants() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    enum { SIPVECTORS = 18 };
+    const size_t lengths[SIPVECTORS] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 63, 64};
+    static const uint8_t sip13vectors[SIPVECTORS][8] = {
+        {0xdc, 0xc4, 0x0f, 0x05, 0x58, 0x01, 0xac, 0xab},
+        {0x93, 0xca, 0x57, 0x7d, 0xf3, 0x9b, 0xf4, 0xc9},
+        {0x4d, 0xd4, 0xc7, 0x4d, 0x02, 0x9b, 0xcb, 0x82},
+        {0xfb, 0xf7, 0xdd, 0xe7, 0xb8, 0x0a, 0xf8, 0x8b},
+        {0x28, 0x83, 0xd3, 0x88, 0x60, 0x57, 0x75, 0xcf},
+        {0x67, 0x3b, 0x53, 0x49, 0x2f, 0xd5, 0xf9, 0xde},
+        {0xa7, 0x22, 0x9f, 0xc5, 0x50, 0x2b, 0x0d, 0xc5},
+        {0x40, 0x11, 0xb1, 0x9b, 0x98, 0x7d, 0x92, 0xd3},
+        {0x8e, 0x9a, 0x29, 0x8d, 0x11, 0x95, 0x90, 0x36},
+        {0xe4, 0x3d, 0x06, 0x6c, 0xb3, 0x8e, 0xa4, 0x25},
+        {0x7f, 0x09, 0xff, 0x92, 0xee, 0x85, 0xde, 0x79},
+        {0x52, 0xc3, 0x4d, 0xf9, 0xc1, 0x18, 0xc1, 0x70},
+        {0xa2, 0xd9, 0xb4, 0x57, 0xb1, 0x84, 0xa3, 0x78},
+        {0xa7, 0xff, 0x29, 0x12, 0x0c, 0x76, 0x6f, 0x30},
+        {0x34, 0x5d, 0xf9, 0xc0, 0x11, 0xa1, 0x5a, 0x60},
+        {0x56, 0x99, 0x51, 0x2a, 0x6d, 0xd8, 0x20, 0xd3},
+        {0xa8, 0xb3, 0xbb, 0xb7, 0x62, 0x90, 0x19, 0x9d},
+        {0x65, 0x60, 0x4a, 0x4b, 0xec, 0x97, 0x79, 0xf1},
+    };
+    static const uint8_t hsip32vectors[SIPVECTORS][4] = {
+        {0xa9, 0x35, 0x9f, 0x5b},
+        {0x27, 0x47, 0x5a, 0xb8},
+        {0xfa, 0x62, 0xa6, 0x03},
+        {0x8a, 0xfe, 0xe7, 0x04},
+        {0x2a, 0x6e, 0x46, 0x89},
+        {0xc5, 0xfa, 0xb6, 0x69},
+        {0x58, 0x63, 0xfc, 0x23},
+        {0x8b, 0xcf, 0x63, 0xc5},
+        {0xd0, 0xb8, 0x84, 0x8f},
+        {0xf8, 0x06, 0xe7, 0x79},
+        {0x94, 0xb0, 0x79, 0x34},
+        {0x08, 0x08, 0x30, 0x50},
+        {0x57, 0xf0, 0x87, 0x2f},
+        {0x77, 0xe6, 0x63, 0xff},
+        {0xd6, 0xff, 0xf8, 0x7c},
+        {0x74, 0xfe, 0x2b, 0x97},
+        {0x59, 0xea, 0x4a, 0x74},
+        {0x48, 0x6b, 0x7f, 0xbc},
+    };
+    static const uint8_t hsip64vectors[SIPVECTORS][8] = {
+        {0x21, 0x8d, 0x1f, 0x59, 0xb9, 0xb8, 0x3c, 0xc8},
+        {0xbe, 0x55, 0x24, 0x12, 0xf8, 0x38, 0x73, 0x15},
+        {0x06, 0x4f, 0x39, 0xef, 0x7c, 0x50, 0xeb, 0x57},
+        {0xce, 0x0f, 0x1a, 0x45, 0xf7, 0x06, 0x06, 0x79},
+        {0xd5, 0xe7, 0x8a, 0x17, 0x5b, 0xe5, 0x2e, 0xa1},
+        {0xcb, 0x9d, 0x7c, 0x3f, 0x2f, 0x3d, 0xb5, 0x80},
+        {0xce, 0x3e, 0x91, 0x35, 0x8a, 0xa2, 0xbc, 0x25},
+        {0xff, 0x20, 0x27, 0x28, 0xb0, 0x7b, 0xc6, 0x84},
+        {0xed, 0xfe, 0xe8, 0x20, 0xbc, 0xe4, 0x85, 0x8c},
+        {0x5b, 0x51, 0xcc, 0xcc, 0x13, 0x88, 0x83, 0x07},
+        {0x95, 0xb0, 0x46, 0x9f, 0x06, 0xa6, 0xf2, 0xee},
+        {0xae, 0x26, 0x33, 0x39, 0x94, 0xdd, 0xcd, 0x48},
+        {0x7b, 0xc7, 0x1f, 0x9f, 0xae, 0xf5, 0xc7, 0x99},
+        {0x5a, 0x23, 0x52, 0xd7, 0x5a, 0x0c, 0x37, 0x44},
+        {0x3b, 0xb1, 0xa8, 0x70, 0xea, 0xe8, 0xe6, 0x58},
+        {0x21, 0x7d, 0x0b, 0xcb, 0x4e, 0x81, 0xc9, 0x02},
+        {0x2e, 0xa6, 0x3c, 0x71, 0xbf, 0x32, 0x60, 0x87},
+        {0x83, 0xa5, 0xc1, 0xd9, 0x34, 0x87, 0x35, 0x44},
+    };
+    uint8_t key[16], msg[64];
+    for (int i = 0; i < 16; ++i) key[i] = (uint8_t) i;
+    for (int i = 0; i < 64; ++i) msg[i] = (uint8_t) i;
+    uint8_t out[8];
+    int result = 0;
+    for (int v = 0; v < SIPVECTORS; ++v) {
+        siphash13(out, msg, lengths[v], key);
+        bool same = memcmp(out, sip13vectors[v], 8) == 0;
+        halfsiphash(out, msg, lengths[v], key, 4);
+        same = same && memcmp(out, hsip32vectors[v], 4) == 0;
+        halfsiphash(out, msg, lengths[v], key, 8);
+        same = same && memcmp(out, hsip64vectors[v], 8) == 0;
+        if (!same) {
+            cerr << "SipHash-1-3 or HalfSipHash does not match the reference vectors at length "
+                 << lengths[v] << endl;
+            result = 1;
+        }
+    }
+    return result;
+}
+
+// the vector multilinear kernels give the same values as the scalar ones
+int testmultilinearavx() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    vector<uint64_t> keys(602);
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = pcg64_random();
+    vector<uint32_t> input(600);
+    for (size_t i = 0; i < input.size(); ++i) input[i] = (uint32_t) pcg64_random();
+    int result = 0;
+    for (size_t length = 0; length <= input.size(); ++length) {
+        const uint32_t expected = hashMultilinear(keys.data(), input.data(), length);
+        bool same = hashMultilinearavx(keys.data(), input.data(), length) == expected;
+        if (length % 2 == 0)
+            same = same && hashMultilinear2by2(keys.data(), input.data(), length) == expected
+                   && hashMultilineardouble(keys.data(), input.data(), length) == expected
+                   && hashMultilinearhalfavx(keys.data(), input.data(), length)
+                      == hashMultilinearhalf(keys.data(), input.data(), length);
+        if (!same) {
+            cerr << "vector multilinear hashing differs at length " << length << endl;
+            result = 1;
+        }
+    }
+    return result;
+}
+
+// hashMultilinear64 and hashMultilinear64avx against the multilinear sum modulo 2^128,
+// on random words and on all-ones keys and words (the largest carries)
+int testmultilinear64() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    vector<uint64_t> keys(2 * 300 + 4);
+    vector<uint64_t> input(300);
+    int result = 0;
+    for (int extreme = 0; extreme < 2; ++extreme) {
+        for (size_t i = 0; i < keys.size(); ++i) keys[i] = extreme ? ~UINT64_C(0) : pcg64_random();
+        for (size_t i = 0; i < input.size(); ++i) input[i] = extreme ? ~UINT64_C(0) : pcg64_random();
+        for (size_t length = 0; length <= input.size(); ++length) {
+            unsigned __int128 sum = ((unsigned __int128) keys[1] << 64) | keys[0];
+            for (size_t i = 0; i <= length; ++i) {
+                const unsigned __int128 key = ((unsigned __int128) keys[2 * i + 3] << 64) | keys[2 * i + 2];
+                sum += (i < length) ? key * input[i] : key;
+            }
+            const uint64_t expected = (uint64_t) (sum >> 64);
+            if ((hashMultilinear64(keys.data(), input.data(), length) != expected)
+                || (hashMultilinear64avx(keys.data(), input.data(), length) != expected)) {
+                cerr << "hashMultilinear64 differs from the multilinear sum at length " << length << endl;
+                result = 1;
+            }
+        }
+    }
+    return result;
+}
+
+// scalar rendering of pdp32avx over length words, hashing finallength in the last step
+uint32_t pdp32reference(const uint64_t * keys, const uint32_t * input, size_t length, uint64_t finallength) {
+    const uint32_t * keys32 = (const uint32_t *) keys;
+    const size_t groups = (length + 7) / 8;
+    uint64_t sum = keys[0] + keys[1] + keys[2] + keys[3];
+    for (size_t i = 0; i < groups * 8; i += 2) {
+        const uint32_t a = (i < length ? input[i] : 0) + keys32[8 + i];
+        const uint32_t b = (i + 1 < length ? input[i + 1] : 0) + keys32[8 + i + 1];
+        sum += (uint64_t) a * b;
+    }
+    const uint64_t * last = keys + 4 * (groups + 1);
+    const uint64_t answer = last[0] + last[1] * (uint32_t) finallength + last[2] * (uint32_t) (finallength >> 32)
+                            + last[3] * (uint32_t) sum + last[4] * (uint32_t) (sum >> 32) + last[5];
+    return (uint32_t) (answer >> 32);
+}
+
+// pdp32avx on any length and any key alignment, against a scalar rendering of it
+int testpdp32avx() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    const size_t maxlength = 600;
+    vector<uint64_t> keys(4 * (maxlength / 8 + 2) + 6 + 1);
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = pcg64_random();
+    vector<uint32_t> input(maxlength);
+    for (size_t i = 0; i < input.size(); ++i) input[i] = (uint32_t) pcg64_random();
+    int result = 0;
+    for (size_t length = 0; length <= maxlength; ++length) {
+        const uint32_t expected = pdp32reference(keys.data(), input.data(), length, length);
+        // the same key bytes, one byte off any alignment
+        vector<char> shifted(keys.size() * sizeof(uint64_t) + 1);
+        memcpy(shifted.data() + 1, keys.data(), keys.size() * sizeof(uint64_t));
+        if (pdp32avx(keys.data(), input.data(), length) != expected
+                || pdp32avx(shifted.data() + 1, input.data(), length) != expected) {
+            cerr << "pdp32avx differs from its scalar rendering at length " << length << endl;
+            result = 1;
+        }
+    }
+    return result;
+}
+
+// Maps a writable page followed by an unreadable one, so that an input ending at
+// pages + pagesize faults on any read past its end. Release with munmap(pages, 2 * pagesize).
+static uint8_t * mapGuardedPage(size_t pagesize) {
+    uint8_t * pages = (uint8_t *) mmap(NULL, 2 * pagesize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages != MAP_FAILED && mprotect(pages + pagesize, pagesize, PROT_NONE) == 0) return pages;
+    cerr << "could not set up a guard page" << endl;
+    if (pages != MAP_FAILED) munmap(pages, 2 * pagesize);
+    return NULL;
+}
+
+struct BytesAndWords {
+    const hashFunctionBytes bytes;
+    const hashFunction words;
+    const bool pairs; // the word function takes an even number of words
+    const string name;
+};
+
+// The byte-string variants against their word functions applied to a padded copy of the
+// words followed by the byte length. The strings end on a page boundary before an
+// unreadable page, so any read past their end faults.
+int testbytes() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    const BytesAndWords functions[] = {
+        {&hashMultilinearBytes, &hashMultilinear, false, "hashMultilinearBytes"},
+        {&hashMultilinearhalfBytes, &hashMultilinearhalf, true, "hashMultilinearhalfBytes"},
+        {&hashNHBytes, &hashNH, true, "hashNHBytes"},
+#ifdef __PCLMUL__
+        {&hashGaloisFieldMultilinearBytes, &hashGaloisFieldMultilinear, false, "hashGaloisFieldMultilinearBytes"},
+        {&hashGaloisFieldMultilinearHalfMultiplicationsBytes, &hashGaloisFieldMultilinearHalfMultiplications, true,
+         "hashGaloisFieldMultilinearHalfMultiplicationsBytes"},
+#endif
+    };
+    const size_t maxlength = 300;
+    const size_t pagesize = sysconf(_SC_PAGESIZE);
+    uint8_t * pages = mapGuardedPage(pagesize);
+    if (pages == NULL) return 1;
+    // hashMultilinearhalfBytes needs the most 64-bit keys among the multilinear functions,
+    // ceil(maxlength / 4) + 4, and pdp32avxBytes needs 4 * (ceil(maxlength / 32) + 1) + 6
+    vector<uint64_t> keys(max((maxlength + 3) / 4 + 4, 4 * (maxlength / 32 + 2) + 6));
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = pcg64_random();
+    vector<uint8_t> input(maxlength);
+    for (size_t i = 0; i < input.size(); ++i) input[i] = (uint8_t) pcg64_random();
+    int result = 0;
+    for (size_t length = 0; length <= maxlength; ++length) {
+        uint8_t * bytes = pages + pagesize - length;
+        memcpy(bytes, input.data(), length);
+        vector<uint32_t> words((length + 3) / 4 + 2, 0);
+        memcpy(words.data(), input.data(), length);
+        words[(length + 3) / 4] = (uint32_t) length;
+        for (const BytesAndWords & f : functions) {
+            const size_t count = f.pairs ? (length + 3) / 4 / 2 * 2 + 2 : (length + 3) / 4 + 1;
+            if (f.bytes(keys.data(), bytes, length) != f.words(keys.data(), words.data(), count)) {
+                cerr << f.name << " differs from its word function at length " << length << endl;
+                result = 1;
+            }
+        }
+        if (pdp32avxBytes(keys.data(), bytes, length) != pdp32reference(keys.data(), words.data(), (length + 3) / 4, length)) {
+            cerr << "pdp32avxBytes differs from its scalar rendering at length " << length << endl;
+            result = 1;
+        }
+    }
+    munmap(pages, 2 * pagesize);
+    return result;
+}
+
+// pyramidal_Multilinear against the plain level-by-level pyramid
+int testpyramidal() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    vector<uint64_t> keys(PYRAMIDAL_MAX_LEVELS * PYRAMIDAL_RANDOM_WORDS_PER_LEVEL);
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = pcg64_random();
+    vector<uint32_t> input(256 * 256 * 3 + 1000);
+    for (size_t i = 0; i < input.size(); ++i) input[i] = (uint32_t) pcg64_random();
+    const size_t lengths[] = {0, 1, 5, 255, 256, 257, 1024, 1025, 256 * 256, 256 * 257 + 3, input.size()};
+    int result = 0;
+    for (size_t length : lengths) {
+        vector<uint32_t> level(input.begin(), input.begin() + length);
+        size_t depth = 0;
+        do {
+            vector<uint32_t> next;
+            for (size_t b = 0; b == 0 || b < level.size(); b += 256)
+                next.push_back(hashMultilinear(keys.data() + depth * PYRAMIDAL_RANDOM_WORDS_PER_LEVEL,
+                                               level.data() + b, min<size_t>(256, level.size() - b)));
+            level.swap(next);
+            ++depth;
+        } while (level.size() > 1);
+        if (pyramidal_Multilinear(keys.data(), input.data(), length) != level[0]) {
+            cerr << "pyramidal_Multilinear differs from the reference at length " << length << endl;
+            result = 1;
+        }
+    }
+    return result;
+}
+
+// hornerHashLanes4/8 against lanes of multHi128 steps, the primitive of hornerHash
+int testhornerlanes() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    uint64_t keys[2] = {pcg64_random(), pcg64_random()};
+    vector<uint64_t> input(300);
+    for (size_t i = 0; i < input.size(); ++i) input[i] = pcg64_random();
+    u128 h;
+    memcpy(&h, keys, sizeof(h));
+    h.lo |= 1;
+    int result = 0;
+    for (size_t lanes = 4; lanes <= 8; lanes += 4) {
+        for (size_t length = 0; length <= input.size(); ++length) {
+            vector<u128> accums(lanes, u128{0, 0});
+            accums[0].hi = length;
+            for (size_t i = 0; i < length; ++i) {
+                accums[i % lanes].lo = input[i];
+                accums[i % lanes] = multHi128(h, accums[i % lanes]);
+            }
+            for (size_t j = 1; j < lanes; ++j) {
+                accums[0].lo = accums[j].hi;
+                accums[0] = multHi128(h, accums[0]);
+            }
+            const uint64_t laned = (lanes == 4) ? hornerHashLanes4(keys, input.data(), length)
+                                   : hornerHashLanes8(keys, input.data(), length);
+            if (laned != accums[0].hi) {
+                cerr << "hornerHashLanes" << lanes << " differs from the reference at length " << length << endl;
+                result = 1;
+            }
+        }
+    }
+    return result;
+}
+
+// every unroll depth stays within the input, hashes its first word, and the
+// selectors (timed or pinned) hash with the depth they hold for each range
+int testunrolldepths() {
+    printf("[%s] %s\n", __FILE__, __func__);
+    struct Family {
+        const UnrollCandidate * candidates;
+        size_t count;
+        const char * name;
+    };
+    const Family families[] = {
+        {unrolledHornerCandidates, sizeof(unrolledHornerCandidates) / sizeof(unrolledHornerCandidates[0]), "unrolledHorner"},
+        {iterateCLCandidates, sizeof(iterateCLCandidates) / sizeof(iterateCLCandidates[0]), "iterateCL"},
+        {treeCLCandidates, sizeof(treeCLCandidates) / sizeof(treeCLCandidates[0]), "treeCL"},
+    };
+    const size_t maxlength = 100;
+    const size_t pagesize = sysconf(_SC_PAGESIZE);
+    uint8_t * pages = mapGuardedPage(pagesize);
+    if (pages == NULL) return 1;
+    uint64_t keys[150];
+    for (size_t i = 0; i < 150; ++i) keys[i] = pcg64_random();
+    vector<uint64_t> input(maxlength);
+    for (size_t i = 0; i < input.size(); ++i) input[i] = pcg64_random();
+    int result = 0;
+    for (const Family & family : families) {
+        const BigEndianUnrollSelector selector(family.candidates, family.count, keys);
+        BigEndianUnrollSelector::Depths depths;
+        for (size_t r = 0; r < BigEndianUnrollSelector::RANGES; ++r)
+            depths.depth[r] = family.candidates[(r + 1) % family.count].depth;
+        const BigEndianUnrollSelector pinned(family.candidates, family.count, depths);
+        for (size_t r = 0; r < BigEndianUnrollSelector::RANGES; ++r) {
+            if (pinned.depth(r) != depths.depth[r]) {
+                cerr << family.name << " selector does not keep the depths it is given" << endl;
+                result = 1;
+            }
+        }
+        for (size_t length = 0; length <= maxlength; ++length) {
+            uint64_t * words = (uint64_t *) (pages + pagesize) - length;
+            memcpy(words, input.data(), length * sizeof(uint64_t));
+            for (size_t c = 0; c < family.count; ++c) {
+                const UnrollCandidate & f = family.candidates[c];
+                const uint64_t h = f.hash(keys, words, length);
+                if (h != f.hash(keys, input.data(), length)) {
+                    cerr << family.name << "<" << f.depth << "> depends on memory past the input at length " << length << endl;
+                    result = 1;
+                }
+                if (length > 0) {
+                    words[0] ^= 1;
+                    if (h == f.hash(keys, words, length)) {
+                        cerr << family.name << "<" << f.depth << "> ignores the first word at length " << length << endl;
+                        result = 1;
+                    }
+                    words[0] ^= 1;
+                }
+                if ((f.depth == selector.depth(BigEndianUnrollSelector::range(length)))
+                    && (h != selector.hash(keys, words, length))) {
+                    cerr << family.name << " selector differs from its pick at length " << length << endl;
+                    result = 1;
+                }
+                if ((f.depth == pinned.depth(BigEndianUnrollSelector::range(length)))
+                    && (h != pinned.hash(keys, words, length))) {
+                    cerr << family.name << " pinned selector differs from its depth at length " << length << endl;
+                    result = 1;
+                }
+            }
+        }
+    }
+    munmap(pages, 2 * pagesize);
+    BigEndianUnrollSelector::Depths parsed = {{0, 0, 0, 0, 0}};
+    const size_t count = sizeof(unrolledHornerCandidates) / sizeof(unrolledHornerCandidates[0]);
+    const bool accepted = BigEndianUnrollSelector::parseDepths("7", unrolledHornerCandidates, count, &parsed)
+                          && (parsed.depth[0] == 7) && (parsed.depth[4] == 7)
+                          && BigEndianUnrollSelector::parseDepths("3,4,5,6,9", unrolledHornerCandidates, count, &parsed)
+                          && (parsed.depth[0] == 3) && (parsed.depth[4] == 9);
+    const char * const rejected[] = {"", "tune", "10", "3,4", "3,4,5,6,9,", "3,4,5,6,9,9", "3;4;5;6;9"};
+    bool rejects = true;
+    for (const char * text : rejected)
+        rejects = rejects && !BigEndianUnrollSelector::parseDepths(text, unrolledHornerCandidates, count, &parsed);
+    if (!accepted || !rejects || (parsed.depth[1] != 4)) {
+        cerr << "parseDepths does not read depth lists as documented" << endl;
+        result = 1;
+    }
+    // an unset variable keeps the defaults, a depth list replaces them and
+    // anything else must abort rather than fall back to the defaults
+    const char * const variable = "HASHUNIT_UNROLLED_HORNER_DEPTHS";
+    unsetenv(variable);
+    const BigEndianUnrollSelector defaults = selectUnrollDepths(unrolledHornerCandidates, count,
+                                                                unrolledHornerDefaultDepths, variable, keys);
+    setenv(variable, "9", 1);
+    const BigEndianUnrollSelector nines = selectUnrollDepths(unrolledHornerCandidates, count,
+                                                             unrolledHornerDefaultDepths, variable, keys);
+    for (size_t r = 0; r < BigEndianUnrollSelector::RANGES; ++r) {
+        if ((defaults.depth(r) != unrolledHornerDefaultDepths.depth[r]) || (nines.depth(r) != 9)) {
+            cerr << "selectUnrollDepths does not pick the depths it is given" << endl;
+            result = 1;
+        }
+    }
+    setenv(variable, "3,4,5,6,10", 1);
+    cout.flush();
+    const pid_t child = fork();
+    if (child == 0) {
+        if (freopen("/dev/null", "w", stderr) == NULL) _exit(2);
+        selectUnrollDepths(unrolledHornerCandidates, count, unrolledHornerDefaultDepths, variable, keys);
+        _exit(0);
+    }
+    int status = 0;
+    if ((child < 0) || (waitpid(child, &status, 0) != child) || !WIFSIGNALED(status)
+            || (WTERMSIG(status) != SIGABRT)) {
+        cerr << "selectUnrollDepths accepts a malformed depth list" << endl;
+        result = 1;
+    }
+    unsetenv(variable);
+    return result;
+}
+
 int main(int c, char ** arg) {
     (void) (c);
     (void) (arg);
     int r = 0;
     r |= testbitflipping();
     r |= testunused();
+    r |= testparallelpmp();
+    r |= testseededpmp();
+    r |= testpmpavx512();
+    r |= testthreadedvhash();
+    r |= teststreamingvhash();
+    r |= testsiphashbatch();
+    r |= testsipvariants();
+    r |= testmultilinearavx();
+    r |= testmultilinear64();
+    r |= testpyramidal();
+    r |= testpdp32avx();
+    r |= testbytes();
+    r |= testhornerlanes();
+    r |= testunrolldepths();
     if(r == 0) cout <<" Your code is probably ok." <<endl;
     else cout << "Your code looks buggy." << endl;
     return r;